@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include "MeshOptimizer.h"
+
+// A FIFO cache tracked with time stamps: a vertex is cached if fewer than cacheSize misses happened since
+// it was last transformed. Starting the clock past cacheSize makes every vertex miss at first
+struct VertexCache
+{
+    std::vector<uint32_t> stamps;
+    uint32_t time;
+    unsigned size;
+
+    VertexCache(size_t vertexCount, unsigned cacheSize)
+        : stamps(vertexCount, 0), time(cacheSize + 1), size(cacheSize)
+    {
+    }
+
+    // Returns whether the vertex was transformed
+    bool Use(uint32_t vertex)
+    {
+        if (time - stamps[vertex] <= size) return false;
+        stamps[vertex] = time++;
+        return true;
+    }
+
+    void Flush()
+    {
+        time += size + 1;
+    }
+};
+
+// For every vertex, the triangles using it
+struct TriangleAdjacency
+{
+    std::vector<uint32_t> offsets; // vertexCount + 1
+    std::vector<uint32_t> triangles;
+};
+
+static void BuildAdjacency(TriangleAdjacency& adjacency, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    adjacency.offsets.assign(vertexCount + 1, 0);
+    for (size_t i = 0; i < indexCount; ++i)
+        ++adjacency.offsets[indices[i] + 1];
+    for (size_t v = 0; v < vertexCount; ++v)
+        adjacency.offsets[v + 1] += adjacency.offsets[v];
+
+    adjacency.triangles.resize(indexCount);
+    std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (size_t i = 0; i < indexCount; ++i)
+        adjacency.triangles[fill[indices[i]]++] = (uint32_t)(i / 3);
+}
+
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize)
+{
+    VertexCache cache(vertexCount, cacheSize);
+    std::vector<uint8_t> used(vertexCount, 0);
+    size_t usedCount = 0;
+    VertexCacheStatistics statistics = {};
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        if (cache.Use(indices[i])) ++statistics.transformedVertices;
+        if (!used[indices[i]]) { used[indices[i]] = 1; ++usedCount; }
+    }
+    if (indexCount >= 3) statistics.acmr = (float)statistics.transformedVertices / (float)(indexCount / 3);
+    if (usedCount > 0) statistics.atvr = (float)statistics.transformedVertices / (float)usedCount;
+    return statistics;
+}
+
+float AnalyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize)
+{
+    // Direct mapped, 2048 lines of 64 bytes; smaller caches than a GPU's turn the reuse between neighbouring
+    // strips into misses, while vertices scattered through a large mesh still show up
+    const size_t LINE_SIZE = 64, LINE_COUNT = 2048;
+    std::vector<size_t> lines(LINE_COUNT, ~(size_t)0);
+    std::vector<uint8_t> used(vertexCount, 0);
+    size_t usedCount = 0;
+    size_t bytesRead = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        size_t start = indices[i] * vertexSize;
+        for (size_t line = start / LINE_SIZE; line <= (start + vertexSize - 1) / LINE_SIZE; ++line)
+        {
+            if (lines[line % LINE_COUNT] == line) continue;
+            lines[line % LINE_COUNT] = line;
+            bytesRead += LINE_SIZE;
+        }
+        if (!used[indices[i]]) { used[indices[i]] = 1; ++usedCount; }
+    }
+    return usedCount > 0 ? (float)bytesRead / (float)(usedCount * vertexSize) : 0.0f;
+}
+
+// Tipsify, from Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+// Fans out around one vertex at a time, then moves on to the neighbour that will still be in the cache
+// after its remaining triangles are emitted; when none will, it backtracks to a recently used vertex
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize)
+{
+    if (indexCount < 3) { memmove(destination, indices, indexCount * sizeof(uint32_t)); return; }
+    std::vector<uint32_t> source(indices, indices + indexCount);
+    size_t triangleCount = indexCount / 3;
+
+    TriangleAdjacency adjacency;
+    BuildAdjacency(adjacency, source.data(), indexCount, vertexCount);
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+    std::vector<uint32_t> stamps(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    size_t cursor = 0;
+    size_t written = 0;
+
+    int64_t fan = source[0];
+    while (fan >= 0)
+    {
+        candidates.clear();
+        for (uint32_t a = adjacency.offsets[fan]; a < adjacency.offsets[fan + 1]; ++a)
+        {
+            uint32_t triangle = adjacency.triangles[a];
+            if (emitted[triangle]) continue;
+            emitted[triangle] = 1;
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                uint32_t v = source[triangle * 3 + corner];
+                destination[written++] = v;
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                if (time - stamps[v] > cacheSize) stamps[v] = time++;
+            }
+        }
+
+        // The candidate that stays cached through its remaining triangles and has been there longest
+        fan = -1;
+        int64_t best = -1;
+        for (uint32_t v : candidates)
+        {
+            if (liveTriangles[v] == 0) continue;
+            int64_t priority = 0;
+            if (time - stamps[v] + 2 * liveTriangles[v] <= cacheSize)
+                priority = time - stamps[v];
+            if (priority > best)
+            {
+                best = priority;
+                fan = v;
+            }
+        }
+        if (fan >= 0) continue;
+
+        // Dead end: something emitted recently, then anything left, in index order
+        while (!deadEnds.empty() && fan < 0)
+        {
+            uint32_t v = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[v] > 0) fan = v;
+        }
+        for (; fan < 0 && cursor < triangleCount; ++cursor)
+            if (!emitted[cursor])
+                fan = source[cursor * 3];
+    }
+    // Indices past the last whole triangle are kept as they were
+    memcpy(destination + written, &source[written], (indexCount - written) * sizeof(uint32_t));
+}
+
+void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+    size_t positionStride, float threshold, unsigned cacheSize)
+{
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) { memmove(destination, indices, indexCount * sizeof(uint32_t)); return; }
+    std::vector<uint32_t> source(indices, indices + indexCount);
+
+    // Hard boundaries: triangles the cache misses on entirely, where nothing is lost by starting over
+    std::vector<uint32_t> clusters;
+    VertexCache cache(vertexCount, cacheSize);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        int misses = cache.Use(source[t * 3]) + cache.Use(source[t * 3 + 1]) + cache.Use(source[t * 3 + 2]);
+        if (misses == 3 || t == 0) clusters.push_back((uint32_t)t);
+    }
+    clusters.push_back((uint32_t)triangleCount);
+
+    // Soft boundaries: within each, cut whenever the miss ratio so far is already as good as the whole
+    // run's, give or take the threshold, so the cut costs no more than that
+    std::vector<uint32_t> soft;
+    for (size_t c = 0; c + 1 < clusters.size(); ++c)
+    {
+        uint32_t begin = clusters[c], end = clusters[c + 1];
+        cache.Flush();
+        size_t clusterMisses = 0;
+        for (uint32_t t = begin; t < end; ++t)
+            clusterMisses += cache.Use(source[t * 3]) + cache.Use(source[t * 3 + 1]) + cache.Use(source[t * 3 + 2]);
+        float target = threshold * (float)clusterMisses / (float)(end - begin);
+
+        cache.Flush();
+        soft.push_back(begin);
+        size_t misses = 0, count = 0;
+        for (uint32_t t = begin; t < end; ++t)
+        {
+            misses += cache.Use(source[t * 3]) + cache.Use(source[t * 3 + 1]) + cache.Use(source[t * 3 + 2]);
+            ++count;
+            if ((float)misses <= target * (float)count && t + 1 < end)
+            {
+                soft.push_back(t + 1);
+                cache.Flush();
+                misses = count = 0;
+            }
+        }
+    }
+    soft.push_back((uint32_t)triangleCount);
+
+    // Area weighted centroid and normal of every cluster, and of the whole mesh
+    size_t clusterCount = soft.size() - 1;
+    std::vector<float> centroids(clusterCount * 3, 0.0f), normals(clusterCount * 3, 0.0f), areas(clusterCount, 0.0f);
+    float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        for (uint32_t t = soft[c]; t < soft[c + 1]; ++t)
+        {
+            const float* p0 = (const float*)((const char*)positions + source[t * 3] * positionStride);
+            const float* p1 = (const float*)((const char*)positions + source[t * 3 + 1] * positionStride);
+            const float* p2 = (const float*)((const char*)positions + source[t * 3 + 2] * positionStride);
+            float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; ++k)
+            {
+                float centre = (p0[k] + p1[k] + p2[k]) / 3.0f;
+                centroids[c * 3 + k] += centre * area;
+                normals[c * 3 + k] += n[k];
+                meshCentroid[k] += centre * area;
+            }
+            areas[c] += area;
+        }
+        meshArea += areas[c];
+    }
+    for (int k = 0; k < 3; ++k)
+        meshCentroid[k] = meshArea > 0.0f ? meshCentroid[k] / meshArea : 0.0f;
+
+    // Clusters further out along their own normal occlude more of the rest, so they go first
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        float* n = &normals[c * 3];
+        float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        float key = 0.0f;
+        for (int k = 0; k < 3 && areas[c] > 0.0f && length > 0.0f; ++k)
+            key += (centroids[c * 3 + k] / areas[c] - meshCentroid[k]) * n[k] / length;
+        sortKeys[c] = key;
+    }
+    std::vector<uint32_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) order[c] = (uint32_t)c;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    size_t written = 0;
+    for (uint32_t c : order)
+    {
+        size_t count = (soft[c + 1] - soft[c]) * 3;
+        memcpy(destination + written, &source[soft[c] * 3], count * sizeof(uint32_t));
+        written += count;
+    }
+    memcpy(destination + written, &source[written], (indexCount - written) * sizeof(uint32_t));
+}
+
+size_t OptimizeVertexFetch(void* destination, uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t vertexSize)
+{
+    std::vector<uint32_t> remap(vertexCount, ~0u);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t& index = remap[indices[i]];
+        if (index == ~0u)
+        {
+            memcpy((char*)destination + next * vertexSize, (const char*)vertices + indices[i] * vertexSize, vertexSize);
+            index = next++;
+        }
+        indices[i] = index;
+    }
+    return next;
+}
+
+float AnalyzeMeshOrder(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize, unsigned cacheSize)
+{
+    return AnalyzeVertexCache(indices, indexCount, vertexCount, cacheSize).atvr + AnalyzeVertexFetch(indices, indexCount, vertexCount, vertexSize);
+}
+
+size_t OptimizeMesh(void* vertices, uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize, size_t positionOffset)
+{
+    // Optimize copies, so the mesh can be left alone if it was better as it was
+    std::vector<uint32_t> optimized(indices, indices + indexCount);
+    OptimizeVertexCache(optimized.data(), optimized.data(), indexCount, vertexCount);
+    OptimizeOverdraw(optimized.data(), optimized.data(), indexCount, (const float*)((const char*)vertices + positionOffset), vertexCount, vertexSize);
+    std::vector<char> fetched(vertexCount * vertexSize);
+    size_t kept = OptimizeVertexFetch(fetched.data(), optimized.data(), indexCount, vertices, vertexCount, vertexSize);
+
+    if (AnalyzeMeshOrder(optimized.data(), indexCount, kept, vertexSize) >= AnalyzeMeshOrder(indices, indexCount, vertexCount, vertexSize))
+        return vertexCount;
+    memcpy(indices, optimized.data(), indexCount * sizeof(uint32_t));
+    memcpy(vertices, fetched.data(), kept * vertexSize);
+    return kept;
+}
@@ -0,0 +1,56 @@
+#ifndef __MeshOptimizer_h__
+#define __MeshOptimizer_h__
+#include <stddef.h>
+#include <stdint.h>
+
+// Reordering of indexed triangle lists, done once when a mesh is loaded, so the GPU does less work
+// drawing it. Nothing about the mesh changes but the order of its triangles and vertices:
+//
+//   OptimizeVertexCache  triangles in an order that reuses transformed vertices (Tipsify)
+//   OptimizeOverdraw     clusters of those triangles reordered so the outside of the mesh draws first,
+//                        giving up a little cache efficiency to let early depth testing reject more
+//   OptimizeVertexFetch  vertices in the order the triangles first use them, so fetches stream
+//
+// Run them in that order; OptimizeMesh does all three, and keeps the mesh as it was when that comes out worse.
+
+// Entries of the post-transform vertex cache to optimize for; real hardware is no worse than this
+#define VERTEX_CACHE_SIZE 16
+
+struct VertexCacheStatistics
+{
+    size_t transformedVertices; // cache misses: vertices the vertex shader ran for
+    float acmr;                 // average cache miss ratio, transformed vertices per triangle: 3 is the worst, ~0.5 the best on large meshes
+    float atvr;                 // average transformed vertex ratio, transformed vertices per vertex: 1 is the best
+};
+
+// Simulate a FIFO post-transform cache of cacheSize entries drawing the indices
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// Bytes of vertex data read per byte of referenced vertices, simulating a 128 KB direct mapped cache of 64 byte lines
+// 1 is the best; vertices scattered through memory read whole lines for a few bytes each
+float AnalyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize);
+
+// Reorder triangles for the post-transform vertex cache; destination may be indices
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// Reorder clusters of a cache optimized triangle list so those facing away from the mesh's centre come first
+// Clusters are cut wherever the cache would be cold anyway, and where the cache miss ratio so far is within
+// threshold times the whole run's; 1.05 costs about 5% in ACMR. destination may be indices.
+// positions points at the first vertex's x, y, z floats, positionStride bytes apart
+void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+    size_t positionStride, float threshold = 1.05f, unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// Copy vertices into destination in the order indices first use them, and rewrite indices to match
+// Vertices no index uses are dropped; returns how many were kept. destination must not overlap vertices
+size_t OptimizeVertexFetch(void* destination, uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t vertexSize);
+
+// A mesh's drawing cost as the passes measure it: ATVR plus overfetch, as if shading a vertex cost about as
+// much as reading it from memory once. Lower is better
+float AnalyzeMeshOrder(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize, unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// All three passes in place, for vertices holding float x, y, z at positionOffset; returns the new vertex count
+// A mesh already in a good order can lose more to overfetch than it gains in the vertex cache; when the result
+// does not lower AnalyzeMeshOrder, the mesh is left exactly as it was
+size_t OptimizeMesh(void* vertices, uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexSize, size_t positionOffset);
+
+#endif
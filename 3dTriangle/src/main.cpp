@@ -7,6 +7,7 @@
 #include <SDL.h>
 
 #include "ErrorHandling.h"
+#include "MeshOptimizer.h"
 #include "ShaderLoader.h"
 
 const int WINDOW_WIDTH = 640;
@@ -71,11 +72,15 @@ int main(int, char**)
 
     GLuint VertexArrayID;
     glCreateVertexArrays(1, &VertexArrayID);
-    static const GLfloat g_vertex_buffer_data[] = {
+    GLfloat g_vertex_buffer_data[] = {
         -1.0f, -1.0f, 0.0f,
         1.0f, -1.0f, 0.0f,
         0.0f, 1.0f, 0.0f,
     };
+    GLuint indices[3] = { 0, 1, 2 };
+    // Reorder the triangles and vertices for the post-transform cache, overdraw and vertex fetch before
+    // uploading, so every DrawElements path below draws them in the order the GPU handles best
+    OptimizeMesh(g_vertex_buffer_data, indices, 3, 3, 3 * sizeof(GLfloat), 0);
     // This will identify our vertex buffer
     GLuint vertexbuffer;
 
@@ -97,7 +102,6 @@ int main(int, char**)
     glVertexArrayVertexBuffer(VertexArrayID, 0, vertexbuffer, 0 /* offset */, 3 * sizeof(GLfloat) /* stride */);
     err_checkGL("Loading Triangle");
 
-    GLuint indices[3] = { 0, 1, 2 };
     // Generate a buffer for the indices
     GLuint elementbuffer;
     glCreateBuffers(1, &elementbuffer);
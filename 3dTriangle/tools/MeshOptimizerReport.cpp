@@ -0,0 +1,189 @@
+// Reports what the mesh optimization passes gain on each mesh.
+// Usage: MeshOptimizerReport [-c cacheSize] [file.obj ...]
+// Without files, a few generated meshes are used, their triangles and vertices shuffled the way a careless
+// exporter might leave them. ACMR and ATVR come from a simulated FIFO post-transform cache, overfetch from
+// a simulated 128 KB cache of 64 byte lines. The last line says whether OptimizeMesh would keep the result.
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "../src/MeshOptimizer.h"
+
+struct Position
+{
+    float x, y, z;
+};
+
+struct ReportMesh
+{
+    std::string name;
+    std::vector<Position> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// Positions and faces only; polygons are split into fans
+static bool LoadObj(const char* path, ReportMesh& mesh)
+{
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) return false;
+    mesh.name = path;
+    char line[4096];
+    while (fgets(line, sizeof(line), file))
+    {
+        if (line[0] == 'v' && line[1] == ' ')
+        {
+            Position p = {};
+            sscanf(line + 2, "%f %f %f", &p.x, &p.y, &p.z);
+            mesh.vertices.push_back(p);
+        }
+        else if (line[0] == 'f' && line[1] == ' ')
+        {
+            std::vector<uint32_t> corners;
+            for (char* token = strtok(line + 2, " \t\r\n"); token != nullptr; token = strtok(nullptr, " \t\r\n"))
+            {
+                long index = strtol(token, nullptr, 10);
+                if (index < 0) index += (long)mesh.vertices.size() + 1;
+                if (index < 1 || index > (long)mesh.vertices.size()) { fclose(file); return false; }
+                corners.push_back((uint32_t)(index - 1));
+            }
+            for (size_t i = 2; i < corners.size(); ++i)
+            {
+                mesh.indices.push_back(corners[0]);
+                mesh.indices.push_back(corners[i - 1]);
+                mesh.indices.push_back(corners[i]);
+            }
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+// A (rings x segments) grid wrapped by position(u, v)
+template <typename Surface>
+static ReportMesh GenerateSurface(const char* name, int rings, int segments, Surface position)
+{
+    ReportMesh mesh;
+    mesh.name = name;
+    for (int j = 0; j <= rings; ++j)
+        for (int i = 0; i <= segments; ++i)
+            mesh.vertices.push_back(position((float)i / segments, (float)j / rings));
+    for (int j = 0; j < rings; ++j)
+    {
+        for (int i = 0; i < segments; ++i)
+        {
+            uint32_t a = j * (segments + 1) + i, b = a + 1, c = a + segments + 1, d = c + 1;
+            uint32_t quad[6] = { a, b, d, a, d, c };
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    return mesh;
+}
+
+// Triangles in random order, and vertices at random places in the buffer
+static void Shuffle(ReportMesh& mesh)
+{
+    std::mt19937 random(1234);
+    size_t triangleCount = mesh.indices.size() / 3;
+    std::vector<uint32_t> order(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t) order[t] = (uint32_t)t;
+    std::shuffle(order.begin(), order.end(), random);
+    std::vector<uint32_t> remap(mesh.vertices.size());
+    for (size_t v = 0; v < remap.size(); ++v) remap[v] = (uint32_t)v;
+    std::shuffle(remap.begin(), remap.end(), random);
+
+    std::vector<uint32_t> indices(mesh.indices.size());
+    for (size_t t = 0; t < triangleCount; ++t)
+        for (int k = 0; k < 3; ++k)
+            indices[t * 3 + k] = remap[mesh.indices[order[t] * 3 + k]];
+    std::vector<Position> vertices(mesh.vertices.size());
+    for (size_t v = 0; v < remap.size(); ++v)
+        vertices[remap[v]] = mesh.vertices[v];
+    mesh.indices.swap(indices);
+    mesh.vertices.swap(vertices);
+    mesh.name += " (shuffled)";
+}
+
+static void Report(ReportMesh& mesh, unsigned cacheSize)
+{
+    size_t indexCount = mesh.indices.size();
+    size_t vertexCount = mesh.vertices.size();
+    VertexCacheStatistics before = AnalyzeVertexCache(mesh.indices.data(), indexCount, vertexCount, cacheSize);
+    float fetchBefore = AnalyzeVertexFetch(mesh.indices.data(), indexCount, vertexCount, sizeof(Position));
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    OptimizeVertexCache(mesh.indices.data(), mesh.indices.data(), indexCount, vertexCount, cacheSize);
+    std::chrono::steady_clock::time_point cached = std::chrono::steady_clock::now();
+    VertexCacheStatistics afterCache = AnalyzeVertexCache(mesh.indices.data(), indexCount, vertexCount, cacheSize);
+
+    OptimizeOverdraw(mesh.indices.data(), mesh.indices.data(), indexCount, &mesh.vertices[0].x, vertexCount, sizeof(Position), 1.05f, cacheSize);
+    std::chrono::steady_clock::time_point sorted = std::chrono::steady_clock::now();
+    VertexCacheStatistics afterOverdraw = AnalyzeVertexCache(mesh.indices.data(), indexCount, vertexCount, cacheSize);
+
+    std::vector<Position> fetched(vertexCount);
+    size_t kept = OptimizeVertexFetch(fetched.data(), mesh.indices.data(), indexCount, mesh.vertices.data(), vertexCount, sizeof(Position));
+    std::chrono::steady_clock::time_point done = std::chrono::steady_clock::now();
+    float fetchAfter = AnalyzeVertexFetch(mesh.indices.data(), indexCount, kept, sizeof(Position));
+
+    std::chrono::duration<double, std::milli> cacheTime = cached - start, overdrawTime = sorted - cached, fetchTime = done - sorted;
+    printf("%s: %u triangles, %u vertices\n", mesh.name.c_str(), (unsigned)(indexCount / 3), (unsigned)vertexCount);
+    printf("  %-16s %8s %8s %10s %10s\n", "", "ACMR", "ATVR", "overfetch", "ms");
+    printf("  %-16s %8.3f %8.3f %10.3f\n", "original", before.acmr, before.atvr, fetchBefore);
+    printf("  %-16s %8.3f %8.3f %10s %10.2f\n", "vertex cache", afterCache.acmr, afterCache.atvr, "", cacheTime.count());
+    printf("  %-16s %8.3f %8.3f %10s %10.2f\n", "+ overdraw", afterOverdraw.acmr, afterOverdraw.atvr, "", overdrawTime.count());
+    printf("  %-16s %8.3f %8.3f %10.3f %10.2f\n", "+ vertex fetch", afterOverdraw.acmr, afterOverdraw.atvr, fetchAfter, fetchTime.count());
+
+    // The same sums as AnalyzeMeshOrder
+    float costBefore = before.atvr + fetchBefore, costAfter = afterOverdraw.atvr + fetchAfter;
+    printf("  ATVR + overfetch %.3f -> %.3f: OptimizeMesh keeps the %s", costBefore, costAfter, costAfter < costBefore ? "reordered mesh" : "original order");
+    if (fetchAfter > fetchBefore)
+        printf(", although overfetch is worse than in the original order");
+    printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+    unsigned cacheSize = VERTEX_CACHE_SIZE;
+    std::vector<ReportMesh> meshes;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+        {
+            cacheSize = (unsigned)atoi(argv[++i]);
+            continue;
+        }
+        meshes.emplace_back();
+        if (!LoadObj(argv[i], meshes.back()))
+        {
+            fprintf(stderr, "Unable to load %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (meshes.empty())
+    {
+        const float PI = 3.14159265f;
+        meshes.push_back(GenerateSurface("grid", 256, 256, [](float u, float v) { return Position{ u, v, 0.0f }; }));
+        meshes.push_back(GenerateSurface("sphere", 128, 256, [PI](float u, float v) {
+            return Position{ sinf(v * PI) * cosf(u * 2 * PI), cosf(v * PI), sinf(v * PI) * sinf(u * 2 * PI) };
+        }));
+        meshes.push_back(GenerateSurface("torus", 64, 512, [PI](float u, float v) {
+            float r = 1.0f + 0.3f * cosf(v * 2 * PI);
+            return Position{ r * cosf(u * 2 * PI), 0.3f * sinf(v * 2 * PI), r * sinf(u * 2 * PI) };
+        }));
+        meshes.push_back(meshes[1]);
+        Shuffle(meshes.back());
+        meshes.push_back(meshes[2]);
+        Shuffle(meshes.back());
+    }
+
+    printf("Cache of %u vertices\n", cacheSize);
+    for (ReportMesh& mesh : meshes)
+        Report(mesh, cacheSize);
+    return 0;
+}
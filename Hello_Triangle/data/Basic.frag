@@ -1,6 +1,6 @@
 #version 450 core
 
-out vec3 color;
+layout(location = 0) out vec3 color;
 
 void main(){
     color = vec3(1,1,1);
@@ -1,7 +1,7 @@
 #version 450 core
 
 layout(location = 0) in vec3 vertexPosition_modelspace;
-uniform mat4 MVP;
+layout(location = 0) uniform mat4 MVP;
 
 void main(){
     gl_Position = MVP * vec4(vertexPosition_modelspace,1);
@@ -0,0 +1,12 @@
+#version 450 core
+
+// Basic.vert for glTF scenes: each draw also gets the world matrix of its node
+// Locations match Gltf.h; the matrix is an instanced attribute, picked by the draw's baseInstance
+
+layout(location = 0) in vec3 vertexPosition_modelspace;
+layout(location = 8) in mat4 drawMatrix;
+layout(location = 0) uniform mat4 MVP;
+
+void main(){
+    gl_Position = MVP * drawMatrix * vec4(vertexPosition_modelspace,1);
+ }
@@ -0,0 +1,24 @@
+#version 450 core
+#extension GL_ARB_shader_draw_parameters : require
+
+// Basic.vert, with the vertices pulled from storage buffers instead of fed in as attributes
+// Buffer bindings and PulledDraw match VertexPulling.h
+
+struct PulledDraw
+{
+    uint firstWord;
+    uint strideWords;
+    uint positionWord;
+    uint padding;
+};
+
+layout(std430, binding = 0) readonly buffer PulledVertices { float vertexWords[]; };
+layout(std430, binding = 1) readonly buffer PulledDraws { PulledDraw draws[]; };
+layout(location = 0) uniform mat4 MVP;
+
+void main(){
+    PulledDraw draw = draws[gl_DrawIDARB];
+    uint word = draw.firstWord + uint(gl_VertexID) * draw.strideWords + draw.positionWord;
+    vec3 vertexPosition_modelspace = vec3(vertexWords[word], vertexWords[word + 1], vertexWords[word + 2]);
+    gl_Position = MVP * vec4(vertexPosition_modelspace,1);
+ }
@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <string.h>
+#include "Archive.h"
+#include "ArchiveFormat.h"
+#include "MappedFile.h"
+
+static const unsigned char* archiveData = nullptr;
+static size_t archiveSize = 0;
+static const ArchiveEntry* archiveEntries = nullptr;
+static uint32_t archiveEntryCount = 0;
+
+bool OpenAssetArchive(const char* filePath)
+{
+    CloseAssetArchive();
+
+    size_t size = 0;
+    const unsigned char* data = MapFile(filePath, &size);
+    if (data == nullptr) return false;
+
+    // Validate everything up front so lookups never have to bounds check
+    const ArchiveHeader* header = (const ArchiveHeader*)data;
+    bool valid = size >= sizeof(ArchiveHeader)
+        && memcmp(header->magic, ARCHIVE_MAGIC, 4) == 0
+        && header->version == ARCHIVE_VERSION
+        && (size - sizeof(ArchiveHeader)) / sizeof(ArchiveEntry) >= header->entryCount;
+    const ArchiveEntry* entries = (const ArchiveEntry*)(data + sizeof(ArchiveHeader));
+    for (uint32_t i = 0; valid && i < header->entryCount; ++i)
+    {
+        valid = entries[i].offset <= size && entries[i].size <= size - entries[i].offset
+            && (i == 0 || entries[i - 1].hash < entries[i].hash);
+    }
+    if (!valid)
+    {
+        UnmapFile(data, size);
+        return false;
+    }
+
+    archiveData = data;
+    archiveSize = size;
+    archiveEntries = entries;
+    archiveEntryCount = header->entryCount;
+    return true;
+}
+
+void CloseAssetArchive()
+{
+    if (archiveData == nullptr) return;
+    UnmapFile(archiveData, archiveSize);
+    archiveData = nullptr;
+    archiveSize = 0;
+    archiveEntries = nullptr;
+    archiveEntryCount = 0;
+}
+
+bool FindArchiveAsset(const char* assetPath, const void** data, size_t* size)
+{
+    if (archiveData == nullptr || assetPath == nullptr) return false;
+
+    uint64_t hash = ArchiveHashPath(assetPath);
+    const ArchiveEntry* end = archiveEntries + archiveEntryCount;
+    const ArchiveEntry* entry = std::lower_bound(archiveEntries, end, hash,
+        [](const ArchiveEntry& e, uint64_t h) { return e.hash < h; });
+    if (entry == end || entry->hash != hash) return false;
+
+    *data = archiveData + entry->offset;
+    *size = (size_t)entry->size;
+    return true;
+}
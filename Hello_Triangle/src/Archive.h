@@ -0,0 +1,15 @@
+#ifndef __Archive_h__
+#define __Archive_h__
+#include <stddef.h>
+
+// Map a packed asset archive (see ArchiveFormat.h) into memory.
+// Only one archive is open at a time; opening another replaces it.
+// Returns false if the file is missing or is not a valid archive.
+bool OpenAssetArchive(const char* filePath);
+// Unmap the current archive. Pointers returned by FindArchiveAsset become invalid.
+void CloseAssetArchive();
+// Look up an asset by its path relative to data/. No file system access is made.
+// On success, data points straight into the mapped archive and stays valid until CloseAssetArchive.
+bool FindArchiveAsset(const char* assetPath, const void** data, size_t* size);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef __ArchiveFormat_h__
+#define __ArchiveFormat_h__
+#include <stdint.h>
+#include <stddef.h>
+
+// On-disk layout of a packed asset archive, shared by the runtime reader and the offline packer.
+//
+//   ArchiveHeader
+//   ArchiveEntry[entryCount]   sorted by hash, so lookups are a binary search
+//   blobs                      each one starts on an ARCHIVE_ALIGNMENT boundary
+//
+// All integers are little-endian.
+
+#define ARCHIVE_MAGIC "PAK1"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_ALIGNMENT 64
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t alignment;
+} ArchiveHeader;
+
+typedef struct {
+    uint64_t hash;   // ArchiveHashPath of the asset's path relative to data/
+    uint64_t offset; // from the start of the archive
+    uint64_t size;   // in bytes
+} ArchiveEntry;
+
+// 64-bit FNV-1a of the path, ignoring case and treating '\' as '/'.
+// Asset names are case-insensitive so that "basic.frag" finds "Basic.frag" on every platform.
+inline uint64_t ArchiveHashPath(const char* path)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (; *path; ++path)
+    {
+        unsigned char c = (unsigned char)*path;
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if (c == '\\') c = '/';
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+#endif
@@ -0,0 +1,530 @@
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#include "AsyncLoader.h"
+#include "Data.h"
+
+struct LoadRequest
+{
+    std::string filePath;
+    std::string dataFilePath;
+    std::promise<std::string> promise;
+    std::function<void(std::string&&)> callback;
+
+    int fd = -1;
+    std::string contents;
+    size_t bytesRead = 0;
+#ifndef _WIN32
+    struct iovec iov;
+#endif
+};
+
+static std::mutex completedMutex;
+static std::vector<std::unique_ptr<LoadRequest>> completed;
+
+static int openFile(const char* filePath)
+{
+#ifdef _WIN32
+    return _open(filePath, _O_RDONLY | _O_BINARY);
+#else
+    return open(filePath, O_RDONLY | O_CLOEXEC);
+#endif
+}
+
+static void closeFile(int fd)
+{
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+// Read at an absolute offset, returning the number of bytes read or -1
+static long long readAt(int fd, char* buffer, size_t count, size_t offset)
+{
+#ifdef _WIN32
+    // Each descriptor belongs to a single worker, so seeking is safe
+    if (_lseeki64(fd, (long long)offset, SEEK_SET) < 0) return -1;
+    return _read(fd, buffer, (unsigned)std::min<size_t>(count, 1u << 30));
+#else
+    ssize_t result;
+    do
+        result = pread(fd, buffer, count, (off_t)offset);
+    while (result < 0 && errno == EINTR);
+    return result;
+#endif
+}
+
+// Open the file a request refers to and size its buffer
+static bool openRequest(LoadRequest& request)
+{
+    request.fd = openFile(request.filePath.c_str());
+    // if the path is not absolute, try the data directory
+    if (request.fd < 0)
+        request.fd = openFile(request.dataFilePath.c_str());
+    if (request.fd < 0)
+    {
+        fprintf(stderr, "Unable to open %s\n", request.filePath.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    struct _stat64 fileStat;
+    if (_fstat64(request.fd, &fileStat) != 0) return false;
+#else
+    struct stat fileStat;
+    if (fstat(request.fd, &fileStat) != 0) return false;
+#endif
+    request.contents.resize((size_t)fileStat.st_size);
+    return true;
+}
+
+// Hand a request's contents back to whoever asked for them
+static void finishRequest(std::unique_ptr<LoadRequest> request)
+{
+    if (request->fd >= 0)
+    {
+        closeFile(request->fd);
+        request->fd = -1;
+    }
+    request->contents.resize(request->bytesRead);
+
+    if (request->callback)
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        completed.push_back(std::move(request));
+    }
+    else
+    {
+        request->promise.set_value(std::move(request->contents));
+    }
+}
+
+class AsyncLoader
+{
+public:
+    virtual ~AsyncLoader() {}
+    virtual void submit(std::unique_ptr<LoadRequest> request) = 0;
+};
+
+// Portable backend: a few threads each reading one file at a time with pread
+class ThreadPoolLoader : public AsyncLoader
+{
+public:
+    explicit ThreadPoolLoader(unsigned threadCount)
+    {
+        for (unsigned i = 0; i < threadCount; ++i)
+            workers.emplace_back([this]() { run(); });
+    }
+
+    ~ThreadPoolLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    void submit(std::unique_ptr<LoadRequest> request) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            pending.push_back(std::move(request));
+        }
+        wake.notify_one();
+    }
+
+private:
+    void run()
+    {
+        for (;;)
+        {
+            std::unique_ptr<LoadRequest> request;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                wake.wait(lock, [this]() { return stopping || !pending.empty(); });
+                // Outstanding requests are still finished when stopping
+                if (pending.empty()) return;
+                request = std::move(pending.front());
+                pending.pop_front();
+            }
+
+            if (openRequest(*request))
+            {
+                while (request->bytesRead < request->contents.size())
+                {
+                    long long result = readAt(request->fd, &request->contents[request->bytesRead],
+                        request->contents.size() - request->bytesRead, request->bytesRead);
+                    if (result <= 0) break;
+                    request->bytesRead += (size_t)result;
+                }
+            }
+            finishRequest(std::move(request));
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex queueMutex;
+    std::condition_variable wake;
+    std::deque<std::unique_ptr<LoadRequest>> pending;
+    bool stopping = false;
+};
+
+#ifdef __linux__
+// Linux backend: one thread opens files and queues reads onto an io_uring, another reaps completions.
+// Many reads are kept in flight at once, and both submissions and completions are handled in batches.
+class UringLoader : public AsyncLoader
+{
+public:
+    static std::unique_ptr<AsyncLoader> create(unsigned entries)
+    {
+        std::unique_ptr<UringLoader> loader(new UringLoader());
+        if (!loader->setup(entries)) return nullptr;
+        loader->submitter = std::thread([raw = loader.get()]() { raw->runSubmitter(); });
+        loader->reaper = std::thread([raw = loader.get()]() { raw->runReaper(); });
+        return loader;
+    }
+
+    ~UringLoader()
+    {
+        if (submitter.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            submitter.join();
+
+            // A no-op with no request attached tells the reaper to stop once everything has landed
+            {
+                std::lock_guard<std::mutex> lock(sqMutex);
+                pushSqe(IORING_OP_NOP, -1, nullptr, 0, 0);
+                flush();
+            }
+            reaper.join();
+        }
+
+        if (sqes != nullptr) munmap(sqes, sqesSize);
+        if (cqRing != nullptr && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing != nullptr) munmap(sqRing, sqRingSize);
+        if (ringFd >= 0) close(ringFd);
+    }
+
+    void submit(std::unique_ptr<LoadRequest> request) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            pending.push_back(std::move(request));
+        }
+        wake.notify_one();
+    }
+
+private:
+    UringLoader() {}
+
+    bool setup(unsigned entries)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ringFd = (int)syscall(__NR_io_uring_setup, entries, &params);
+        if (ringFd < 0) return false;
+
+        sqEntries = params.sq_entries;
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap)
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+        void* mapped = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        if (mapped == MAP_FAILED) return false;
+        sqRing = (char*)mapped;
+
+        if (singleMmap)
+        {
+            cqRing = sqRing;
+        }
+        else
+        {
+            mapped = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+            if (mapped == MAP_FAILED) return false;
+            cqRing = (char*)mapped;
+        }
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        mapped = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (mapped == MAP_FAILED) return false;
+        sqes = (io_uring_sqe*)mapped;
+
+        sqHead = (unsigned*)(sqRing + params.sq_off.head);
+        sqTail = (unsigned*)(sqRing + params.sq_off.tail);
+        sqMask = *(unsigned*)(sqRing + params.sq_off.ring_mask);
+        sqArray = (unsigned*)(sqRing + params.sq_off.array);
+        cqHead = (unsigned*)(cqRing + params.cq_off.head);
+        cqTail = (unsigned*)(cqRing + params.cq_off.tail);
+        cqMask = *(unsigned*)(cqRing + params.cq_off.ring_mask);
+        cqes = (io_uring_cqe*)(cqRing + params.cq_off.cqes);
+        return true;
+    }
+
+    // Caller must hold sqMutex
+    void pushSqe(unsigned char opcode, int fd, const struct iovec* iov, size_t offset, uint64_t userData)
+    {
+        unsigned tail = *sqTail;
+        unsigned index = tail & sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        sqe->addr = (uint64_t)(uintptr_t)iov;
+        sqe->len = iov != nullptr ? 1 : 0;
+        sqe->off = offset;
+        sqe->user_data = userData;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++unsubmitted;
+    }
+
+    // Caller must hold sqMutex
+    void pushRead(LoadRequest* request)
+    {
+        request->iov.iov_base = &request->contents[request->bytesRead];
+        request->iov.iov_len = request->contents.size() - request->bytesRead;
+        pushSqe(IORING_OP_READV, request->fd, &request->iov, request->bytesRead, (uint64_t)(uintptr_t)request);
+    }
+
+    // Hand every queued entry to the kernel in one call. Caller must hold sqMutex
+    void flush()
+    {
+        while (unsubmitted > 0)
+        {
+            int result = (int)syscall(__NR_io_uring_enter, ringFd, unsubmitted, 0, 0, nullptr, 0);
+            if (result < 0)
+            {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+                fprintf(stderr, "io_uring_enter failed: %s\n", strerror(errno));
+                return;
+            }
+            unsubmitted -= (unsigned)result;
+        }
+    }
+
+    void runSubmitter()
+    {
+        for (;;)
+        {
+            std::deque<std::unique_ptr<LoadRequest>> batch;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                wake.wait(lock, [this]() { return stopping || !pending.empty(); });
+                if (pending.empty()) return;
+                batch.swap(pending);
+            }
+
+            for (std::unique_ptr<LoadRequest>& request : batch)
+            {
+                if (!openRequest(*request) || request->contents.empty())
+                {
+                    finishRequest(std::move(request));
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(sqMutex);
+                if (inFlight == sqEntries)
+                {
+                    // Make sure what is queued can actually complete before waiting on it
+                    flush();
+                    slotFree.wait(lock, [this]() { return inFlight < sqEntries; });
+                }
+                ++inFlight;
+                pushRead(request.release());
+            }
+
+            std::lock_guard<std::mutex> lock(sqMutex);
+            flush();
+        }
+    }
+
+    void runReaper()
+    {
+        bool stopSeen = false;
+        std::vector<LoadRequest*> resubmit;
+        std::vector<std::unique_ptr<LoadRequest>> finished;
+        while (!stopSeen || inFlightSnapshot() > 0)
+        {
+            int result = (int)syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                fprintf(stderr, "io_uring_enter failed: %s\n", strerror(errno));
+                return;
+            }
+
+            unsigned head = *cqHead;
+            unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head)
+            {
+                const io_uring_cqe& cqe = cqes[head & cqMask];
+                LoadRequest* request = (LoadRequest*)(uintptr_t)cqe.user_data;
+                if (request == nullptr)
+                {
+                    stopSeen = true;
+                    continue;
+                }
+
+                if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+                {
+                    resubmit.push_back(request);
+                    continue;
+                }
+                if (cqe.res > 0)
+                    request->bytesRead += (size_t)cqe.res;
+                // Short reads are continued; errors and early end of file finish with what was read
+                if (cqe.res > 0 && request->bytesRead < request->contents.size())
+                    resubmit.push_back(request);
+                else
+                    finished.emplace_back(request);
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+            {
+                std::lock_guard<std::mutex> lock(sqMutex);
+                for (LoadRequest* request : resubmit)
+                    pushRead(request);
+                flush();
+                inFlight -= (unsigned)finished.size();
+            }
+            if (!finished.empty())
+                slotFree.notify_one();
+            resubmit.clear();
+
+            for (std::unique_ptr<LoadRequest>& request : finished)
+                finishRequest(std::move(request));
+            finished.clear();
+        }
+    }
+
+    unsigned inFlightSnapshot()
+    {
+        std::lock_guard<std::mutex> lock(sqMutex);
+        return inFlight;
+    }
+
+    int ringFd = -1;
+    char* sqRing = nullptr;
+    char* cqRing = nullptr;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+    unsigned sqEntries = 0;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    std::mutex sqMutex; // guards the submission ring, unsubmitted and inFlight
+    std::condition_variable slotFree;
+    unsigned unsubmitted = 0;
+    unsigned inFlight = 0;
+
+    std::mutex queueMutex;
+    std::condition_variable wake;
+    std::deque<std::unique_ptr<LoadRequest>> pending;
+    bool stopping = false;
+
+    std::thread submitter;
+    std::thread reaper;
+};
+#endif
+
+static AsyncLoader& loader()
+{
+    static std::unique_ptr<AsyncLoader> instance = []() -> std::unique_ptr<AsyncLoader> {
+#ifdef __linux__
+        // io_uring may be missing from older kernels or disabled by policy
+        if (std::unique_ptr<AsyncLoader> uring = UringLoader::create(128))
+            return uring;
+#endif
+        return std::unique_ptr<AsyncLoader>(new ThreadPoolLoader(4));
+    }();
+    return *instance;
+}
+
+static void startLoad(const char* filePath, std::unique_ptr<LoadRequest> request)
+{
+    const void* packedData;
+    size_t packedSize;
+    if (filePath == nullptr || filePath[0] == 0)
+    {
+        finishRequest(std::move(request));
+    }
+    else if (findPackedFile(filePath, &packedData, &packedSize))
+    {
+        request->contents.assign((const char*)packedData, packedSize);
+        request->bytesRead = packedSize;
+        finishRequest(std::move(request));
+    }
+    else
+    {
+        // Resolve the data directory here; DataPathToFilePath is not safe to call from the I/O threads
+        request->filePath = filePath;
+        request->dataFilePath = DataPathToFilePath(filePath);
+        loader().submit(std::move(request));
+    }
+}
+
+std::future<std::string> loadFileAsync(const char* filePath)
+{
+    std::unique_ptr<LoadRequest> request(new LoadRequest());
+    std::future<std::string> future = request->promise.get_future();
+    startLoad(filePath, std::move(request));
+    return future;
+}
+
+void loadFileAsync(const char* filePath, std::function<void(std::string&&)> callback)
+{
+    std::unique_ptr<LoadRequest> request(new LoadRequest());
+    request->callback = std::move(callback);
+    startLoad(filePath, std::move(request));
+}
+
+void pumpAsyncLoads()
+{
+    std::vector<std::unique_ptr<LoadRequest>> batch;
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        if (completed.empty()) return;
+        batch.swap(completed);
+    }
+    for (std::unique_ptr<LoadRequest>& request : batch)
+        request->callback(std::move(request->contents));
+}
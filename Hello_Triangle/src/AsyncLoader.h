@@ -0,0 +1,21 @@
+#ifndef __AsyncLoader_h__
+#define __AsyncLoader_h__
+#include <functional>
+#include <future>
+#include <string>
+
+// Asynchronous counterparts to loadFile.
+// Reads are serviced by io_uring on Linux, or by a small pool of threads calling pread everywhere else
+// (and on kernels where io_uring is unavailable). Paths are resolved the same way as loadFile: packed
+// assets first, then the path as given, then the data directory. A file that cannot be read produces
+// an empty string.
+
+// Start reading a file; the future becomes ready as soon as the read completes
+std::future<std::string> loadFileAsync(const char* filePath);
+// Start reading a file; the callback runs on the thread that calls pumpAsyncLoads
+void loadFileAsync(const char* filePath, std::function<void(std::string&&)> callback);
+// Run the callbacks of every load that has completed since the last call
+// Call this once per frame from the render thread
+void pumpAsyncLoads();
+
+#endif
@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include "BlockLayout.h"
+
+bool CheckBlockLayout(GLuint program, uint32_t blockNameHash, BlockPacking packing,
+    const BlockMemberDescription* members, size_t memberCount, size_t blockSize)
+{
+    const ProgramReflection* reflection = GetProgramReflection(program);
+    ShaderResourceKind blockKind = packing == BlockPacking::Std140 ? ShaderResourceKind::UniformBlock : ShaderResourceKind::StorageBlock;
+    ShaderResourceKind memberKind = packing == BlockPacking::Std140 ? ShaderResourceKind::Uniform : ShaderResourceKind::BufferVariable;
+    const ShaderResource* block = FindShaderResource(reflection, blockKind, blockNameHash);
+    if (block == nullptr) return true;
+
+    bool matches = true;
+    if (block->dataSize > (GLint)blockSize)
+    {
+        fprintf(stderr, "Block 0x%08x in program %u is %d bytes; the C++ struct is only %u\n",
+            blockNameHash, program, block->dataSize, (unsigned)blockSize);
+        matches = false;
+    }
+
+    size_t found = 0;
+    for (size_t i = 0; i < memberCount; ++i)
+    {
+        const BlockMemberDescription& member = members[i];
+        const ShaderResource* resource = FindShaderResource(reflection, memberKind, member.nameHash);
+        if (resource == nullptr || resource->blockIndex != block->blockIndex)
+            resource = FindShaderResource(reflection, memberKind, member.qualifiedNameHash);
+        // Unused std430 members may be optimized away, so a member the program does not have is fine
+        if (resource == nullptr || resource->blockIndex != block->blockIndex) continue;
+
+        ++found;
+        if (resource->offset != member.offset
+            || (member.arrayStride != 0 && resource->arrayStride != member.arrayStride)
+            || (member.matrixStride != 0 && resource->matrixStride != member.matrixStride))
+        {
+            fprintf(stderr, "Member 0x%08x of block 0x%08x in program %u is at offset %d (array stride %d, matrix stride %d); "
+                "the C++ struct has it at %d (%d, %d)\n", member.nameHash, blockNameHash, program,
+                resource->offset, resource->arrayStride, resource->matrixStride, member.offset, member.arrayStride, member.matrixStride);
+            matches = false;
+        }
+    }
+
+    // Anything left over is in the GLSL block but not in the struct
+    size_t blockMembers = 0;
+    for (const ShaderResource& resource : reflection->resources)
+        if (resource.kind == memberKind && resource.blockIndex == block->blockIndex)
+            ++blockMembers;
+    if (blockMembers != found)
+    {
+        fprintf(stderr, "Block 0x%08x in program %u has %u members the C++ struct does not describe\n",
+            blockNameHash, program, (unsigned)(blockMembers - found));
+        matches = false;
+    }
+    return matches;
+}
@@ -0,0 +1,188 @@
+#ifndef __BlockLayout_h__
+#define __BlockLayout_h__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "ProgramReflection.h"
+
+// C++ structs that match GLSL std140 (uniform block) and std430 (shader storage block) layouts exactly,
+// so filling a block is a single memcpy into a mapped buffer:
+//
+//   struct Camera { mat4 viewProjection; vec3 position; float time; };   // uniform Camera { ... };
+//   typedef Std140Layout<Camera,
+//       BLOCK_MEMBER(Camera, viewProjection),
+//       BLOCK_MEMBER(Camera, position),
+//       BLOCK_MEMBER(Camera, time)> CameraLayout;
+//
+// The layout works out where std140/std430 puts each member at compile time, and static_asserts that
+// the struct has it there; pad the struct by hand where it does not. Members are listed in declaration
+// order. Scalars, vectors, mat4 and arrays of them are supported; mat3 and nested structs are not
+// (their GLSL layout has padding a glm type does not), so use mat4 or vec4 columns instead.
+// CheckBlockLayout compares the layout against what the driver actually linked. The GLSL block must be
+// named after the C++ struct.
+
+enum class BlockPacking
+{
+    Std140,
+    Std430
+};
+
+// Base alignment and size of a GLSL type, by the C++ type that mirrors it
+template <typename T>
+struct BlockType
+{
+    static_assert(sizeof(T) == 0, "No block layout for this type; use scalars, vectors, mat4 or arrays of them");
+};
+
+#define DEFINE_BLOCK_TYPE(Type, Alignment, Size) \
+    template <> \
+    struct BlockType<Type> \
+    { \
+        static constexpr size_t alignment = Alignment; \
+        static constexpr size_t size = Size; \
+        static constexpr size_t matrixStride = 0; \
+    };
+
+DEFINE_BLOCK_TYPE(GLfloat, 4, 4)
+DEFINE_BLOCK_TYPE(GLint, 4, 4)
+DEFINE_BLOCK_TYPE(GLuint, 4, 4)
+DEFINE_BLOCK_TYPE(glm::vec2, 8, 8)
+DEFINE_BLOCK_TYPE(glm::ivec2, 8, 8)
+DEFINE_BLOCK_TYPE(glm::uvec2, 8, 8)
+DEFINE_BLOCK_TYPE(glm::vec3, 16, 12)
+DEFINE_BLOCK_TYPE(glm::ivec3, 16, 12)
+DEFINE_BLOCK_TYPE(glm::uvec3, 16, 12)
+DEFINE_BLOCK_TYPE(glm::vec4, 16, 16)
+DEFINE_BLOCK_TYPE(glm::ivec4, 16, 16)
+DEFINE_BLOCK_TYPE(glm::uvec4, 16, 16)
+
+// Four vec4 columns, the same in both packings
+template <>
+struct BlockType<glm::mat4>
+{
+    static constexpr size_t alignment = 16;
+    static constexpr size_t size = 64;
+    static constexpr size_t matrixStride = 16;
+};
+
+constexpr size_t BlockRoundUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// A member's layout under a packing; arrays are where std140 and std430 differ
+template <BlockPacking Packing, typename T>
+struct BlockPackedType
+{
+    static constexpr size_t alignment = BlockType<T>::alignment;
+    static constexpr size_t size = BlockType<T>::size;
+    static constexpr size_t arrayStride = 0;
+    static constexpr size_t matrixStride = BlockType<T>::matrixStride;
+};
+
+template <BlockPacking Packing, typename T, size_t N>
+struct BlockPackedType<Packing, T[N]>
+{
+    // std140 rounds array elements up to a vec4; std430 only to their own alignment
+    static constexpr size_t alignment = Packing == BlockPacking::Std140 ? BlockRoundUp(BlockType<T>::alignment, 16) : BlockType<T>::alignment;
+    static constexpr size_t arrayStride = BlockRoundUp(BlockType<T>::size, alignment);
+    static constexpr size_t size = arrayStride * N;
+    static constexpr size_t matrixStride = BlockType<T>::matrixStride;
+
+    static_assert(sizeof(T) == arrayStride, "Array elements are packed tighter in C++ than in the block; use an array of vec4 instead");
+};
+
+// One member of a block struct; use BLOCK_MEMBER rather than spelling this out
+// Members are found in the linked program by their own name, or by "Block.member" when the GLSL block has an instance name
+template <typename T, size_t Offset, uint32_t BlockNameHash, uint32_t NameHash, uint32_t QualifiedNameHash>
+struct BlockMember
+{
+    typedef T Type;
+    static constexpr size_t offset = Offset;
+    static constexpr uint32_t blockNameHash = BlockNameHash;
+    static constexpr uint32_t nameHash = NameHash;
+    static constexpr uint32_t qualifiedNameHash = QualifiedNameHash;
+};
+
+#define BLOCK_MEMBER(Block, member) \
+    BlockMember<decltype(Block::member), offsetof(Block, member), ShaderNameHash(#Block), ShaderNameHash(#member), \
+        ShaderNameHash(#member, ShaderNameHash(".", ShaderNameHash(#Block)))>
+
+// Walk the members in order, placing each one where GLSL would and checking the struct agrees
+// Start is where the previous member ended
+template <BlockPacking Packing, size_t Start, typename... Members>
+struct BlockMemberPlacement
+{
+    static constexpr size_t end = Start;
+};
+
+template <BlockPacking Packing, size_t Start, typename First, typename... Rest>
+struct BlockMemberPlacement<Packing, Start, First, Rest...>
+{
+    typedef BlockPackedType<Packing, typename First::Type> Packed;
+    static constexpr size_t offset = BlockRoundUp(Start, Packed::alignment);
+    static_assert(First::offset == offset, "Member is not where the GLSL block layout puts it; pad the struct to match");
+    static_assert(sizeof(typename First::Type) == Packed::size, "Member is a different size in C++ than in the block");
+
+    // std140 starts whatever follows an array on a vec4 boundary; the stride already guarantees that
+    static constexpr size_t end = BlockMemberPlacement<Packing, offset + Packed::size, Rest...>::end;
+};
+
+// What CheckBlockLayout compares against the linked program
+struct BlockMemberDescription
+{
+    uint32_t nameHash;
+    uint32_t qualifiedNameHash;
+    GLint offset;
+    GLint arrayStride;  // 0 for members that are not arrays
+    GLint matrixStride; // 0 for members that are not matrices
+};
+
+template <BlockPacking Packing, typename Block, typename First, typename... Rest>
+struct BufferBlockLayout
+{
+    typedef Block BlockType;
+    static constexpr BlockPacking packing = Packing;
+    static constexpr uint32_t blockNameHash = First::blockNameHash;
+    // Bytes of the struct the block actually covers
+    static constexpr size_t size = BlockMemberPlacement<Packing, 0, First, Rest...>::end;
+
+    static_assert(std::is_standard_layout<Block>::value, "Block structs must be standard layout for offsetof to be meaningful");
+    static_assert(std::is_trivially_copyable<Block>::value, "Block structs are written with memcpy, so must be trivially copyable");
+    static_assert(size <= sizeof(Block), "Block layout runs past the end of the struct");
+
+    static const BlockMemberDescription* Members()
+    {
+        typedef BlockPackedType<Packing, typename First::Type> FirstPacked;
+        static const BlockMemberDescription members[] = {
+            { First::nameHash, First::qualifiedNameHash, (GLint)First::offset, (GLint)FirstPacked::arrayStride, (GLint)FirstPacked::matrixStride },
+            { Rest::nameHash, Rest::qualifiedNameHash, (GLint)Rest::offset,
+                (GLint)BlockPackedType<Packing, typename Rest::Type>::arrayStride, (GLint)BlockPackedType<Packing, typename Rest::Type>::matrixStride }...
+        };
+        return members;
+    }
+    static constexpr size_t memberCount = 1 + sizeof...(Rest);
+};
+
+template <typename Block, typename... Members>
+using Std140Layout = BufferBlockLayout<BlockPacking::Std140, Block, Members...>;
+template <typename Block, typename... Members>
+using Std430Layout = BufferBlockLayout<BlockPacking::Std430, Block, Members...>;
+
+// Compare a block's C++ layout with the one the driver linked for program
+// Mismatched offsets or strides, GLSL members missing from the struct, and a struct smaller than the block
+// are reported on stderr. Returns false if there were any; a program that does not use the block passes
+bool CheckBlockLayout(GLuint program, uint32_t blockNameHash, BlockPacking packing,
+    const BlockMemberDescription* members, size_t memberCount, size_t blockSize);
+
+template <typename Layout>
+bool CheckBlockLayout(GLuint program)
+{
+    return CheckBlockLayout(program, Layout::blockNameHash, Layout::packing,
+        Layout::Members(), Layout::memberCount, sizeof(typename Layout::BlockType));
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include <fstream>
+#include <sstream>
 #include <SDL.h>
+#include "Archive.h"
 #include "Data.h"
 
 std::string DataPathToFilePath(const char *path)
@@ -19,30 +21,62 @@ std::string DataPathToFilePath(const char *path)
     return dataPath + path;
 }
 
-std::string loadFile(const char* filePath)
+bool findPackedFile(const char* filePath, const void** data, size_t* size)
+{
+    // The archive is mapped in on first use and stays mapped for the life of the program
+    static const bool archiveOpen = OpenAssetArchive(DataPathToFilePath("data.pak").c_str());
+    return archiveOpen && FindArchiveAsset(filePath, data, size);
+}
+
+bool tryLoadFile(const char* filePath, std::string& contents)
 {
+    contents.clear();
     if (filePath == nullptr || filePath[0] == 0)
     {
-        return "";
+        return false;
     }
-    // Read the Vertex Shader code from the file
-    std::string fileContents;
-    std::ifstream fileStream(filePath, std::ios::in);
+
+    // Packed assets are already mapped in, so they cost no file system access at all
+    const void* archiveData;
+    size_t archiveSize;
+    if (findPackedFile(filePath, &archiveData, &archiveSize))
+    {
+        contents.assign((const char*)archiveData, archiveSize);
+        return true;
+    }
+
+    std::ifstream fileStream(filePath, std::ios::in | std::ios::binary);
 
     // if the path is not absolute, try the data directory
     if (!fileStream.good())
     {
-        fileStream = std::ifstream(DataPathToFilePath(filePath), std::ios::in);
+        fileStream = std::ifstream(DataPathToFilePath(filePath), std::ios::in | std::ios::binary);
     }
 
-    // If we still can't find the file, something has gone wrong
-    SDL_assert(fileStream.is_open());
+    if (!fileStream.is_open())
+    {
+        return false;
+    }
+
+    // Read the contents as they are, the same as the archive and loadFileAsync give them back
+    std::ostringstream contentStream;
+    contentStream << fileStream.rdbuf();
+    contents = contentStream.str();
+    return true;
+}
+
+std::string loadFile(const char* filePath)
+{
+    if (filePath == nullptr || filePath[0] == 0)
+    {
+        return "";
+    }
+
+    std::string fileContents;
+    bool found = tryLoadFile(filePath, fileContents);
 
-    // Read the contents
-    std::string Line = "";
-    while (getline(fileStream, Line))
-        fileContents += "\n" + Line;
-    fileStream.close();
+    // If we can't find the file, something has gone wrong
+    SDL_assert(found);
 
     return fileContents;
 }
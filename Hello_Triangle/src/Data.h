@@ -4,5 +4,9 @@
 
 std::string DataPathToFilePath(const char *path);
 std::string loadFile(const char* filePath);
+// Same as loadFile, but a missing file is reported by returning false instead of asserting
+bool tryLoadFile(const char* filePath, std::string& contents);
+// Look up a file in the packed data archive without touching the file system
+bool findPackedFile(const char* filePath, const void** data, size_t* size);
 
 #endif
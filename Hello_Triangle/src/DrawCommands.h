@@ -0,0 +1,22 @@
+#ifndef __DrawCommands_h__
+#define __DrawCommands_h__
+#include <GL/glew.h>
+
+// Layouts GL reads from a GL_DRAW_INDIRECT_BUFFER
+
+typedef struct {
+    GLuint count;
+    GLuint primCount;
+    GLuint first;
+    GLuint baseInstance;
+} DrawArraysIndirectCommand;
+
+typedef struct {
+    GLuint count;
+    GLuint primCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+} DrawElementsIndirectCommand;
+
+#endif
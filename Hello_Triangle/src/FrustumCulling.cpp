@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <functional>
+#include <math.h>
+#include <string.h>
+#include "FrustumCulling.h"
+#include "SimdLanes.h"
+#include "WorkerPool.h"
+
+// Objects culled by one worker at a time; a multiple of CULLING_PADDING
+const size_t CULLING_BLOCK_SIZE = 16384;
+
+static glm::vec4 Row(const glm::mat4& m, int i)
+{
+    return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+}
+
+Frustum ExtractFrustum(const glm::mat4& viewProjection)
+{
+    // Clip space is -w <= x, y, z <= w; each side is a sum or difference of rows (Gribb and Hartmann)
+    Frustum frustum;
+    glm::vec4 w = Row(viewProjection, 3);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        glm::vec4 row = Row(viewProjection, axis);
+        frustum.planes[axis * 2] = w + row;
+        frustum.planes[axis * 2 + 1] = w - row;
+    }
+    for (glm::vec4& plane : frustum.planes)
+    {
+        float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0.0f) plane = plane * (1.0f / length);
+    }
+    return frustum;
+}
+
+static size_t PaddedCount(size_t count)
+{
+    return (count + CULLING_PADDING - 1) / CULLING_PADDING * CULLING_PADDING;
+}
+
+void ResizeCullingBounds(CullingAabbs& bounds, size_t count)
+{
+    size_t padded = PaddedCount(count);
+    bounds.centerX.resize(padded);
+    bounds.centerY.resize(padded);
+    bounds.centerZ.resize(padded);
+    bounds.extentX.resize(padded);
+    bounds.extentY.resize(padded);
+    bounds.extentZ.resize(padded);
+    bounds.count = count;
+}
+
+void ResizeCullingBounds(CullingSpheres& bounds, size_t count)
+{
+    size_t padded = PaddedCount(count);
+    bounds.centerX.resize(padded);
+    bounds.centerY.resize(padded);
+    bounds.centerZ.resize(padded);
+    bounds.radius.resize(padded);
+    bounds.count = count;
+}
+
+void SetCullingAabb(CullingAabbs& bounds, size_t index, const glm::vec3& low, const glm::vec3& high)
+{
+    bounds.centerX[index] = (low.x + high.x) * 0.5f;
+    bounds.centerY[index] = (low.y + high.y) * 0.5f;
+    bounds.centerZ[index] = (low.z + high.z) * 0.5f;
+    bounds.extentX[index] = (high.x - low.x) * 0.5f;
+    bounds.extentY[index] = (high.y - low.y) * 0.5f;
+    bounds.extentZ[index] = (high.z - low.z) * 0.5f;
+}
+
+void SetCullingSphere(CullingSpheres& bounds, size_t index, const glm::vec3& center, float radius)
+{
+    bounds.centerX[index] = center.x;
+    bounds.centerY[index] = center.y;
+    bounds.centerZ[index] = center.z;
+    bounds.radius[index] = radius;
+}
+
+void TransformAabb(const glm::mat4& matrix, const glm::vec3& low, const glm::vec3& high, glm::vec3& transformedLow, glm::vec3& transformedHigh)
+{
+    glm::vec3 center = (low + high) * 0.5f, extent = (high - low) * 0.5f;
+    for (int i = 0; i < 3; ++i)
+    {
+        float c = matrix[3][i], e = 0.0f;
+        for (int j = 0; j < 3; ++j)
+        {
+            c += matrix[j][i] * center[j];
+            e += fabsf(matrix[j][i]) * extent[j];
+        }
+        transformedLow[i] = c - e;
+        transformedHigh[i] = c + e;
+    }
+}
+
+// Append the indices of the lanes set in mask without branching: every lane is written, and the
+// write position only moves past the visible ones
+static inline size_t WriteVisible(unsigned mask, size_t first, size_t end, uint32_t* out, size_t written)
+{
+    if (first + SIMD_LANES > end)
+        mask &= (1u << (end - first)) - 1u;
+    for (unsigned lane = 0; lane < SIMD_LANES; ++lane)
+    {
+        out[written] = (uint32_t)(first + lane);
+        written += (mask >> lane) & 1u;
+    }
+    return written;
+}
+
+// Cull [begin, end) into out, which has room up to the padded end; begin is a multiple of CULLING_PADDING
+static size_t CullAabbBlock(const Frustum& frustum, const CullingAabbs& bounds, size_t begin, size_t end, uint32_t* out)
+{
+    size_t written = 0;
+#if SIMD_LANES > 1
+    // A box is outside a plane when even its corner furthest along the plane's normal is behind it:
+    // dot(normal, center) + w + dot(abs(normal), extent) < 0
+    Lanes planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        const glm::vec4& plane = frustum.planes[p];
+        planeX[p] = Splat(plane.x);
+        planeY[p] = Splat(plane.y);
+        planeZ[p] = Splat(plane.z);
+        planeW[p] = Splat(plane.w);
+        absX[p] = Splat(fabsf(plane.x));
+        absY[p] = Splat(fabsf(plane.y));
+        absZ[p] = Splat(fabsf(plane.z));
+    }
+    for (size_t i = begin; i < end; i += SIMD_LANES)
+    {
+        Lanes cx = Load(&bounds.centerX[i]), cy = Load(&bounds.centerY[i]), cz = Load(&bounds.centerZ[i]);
+        Lanes ex = Load(&bounds.extentX[i]), ey = Load(&bounds.extentY[i]), ez = Load(&bounds.extentZ[i]);
+        Lanes outside = Zero();
+        for (int p = 0; p < 6; ++p)
+        {
+            Lanes distance = Add(Add(Mul(planeX[p], cx), Mul(planeY[p], cy)), Add(Mul(planeZ[p], cz), planeW[p]));
+            Lanes reach = Add(Add(Mul(absX[p], ex), Mul(absY[p], ey)), Mul(absZ[p], ez));
+            outside = Or(outside, LessThanZero(Add(distance, reach)));
+        }
+        written = WriteVisible(~LaneMask(outside) & ((1u << SIMD_LANES) - 1u), i, end, out, written);
+    }
+#else
+    for (size_t i = begin; i < end; ++i)
+    {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; ++p)
+        {
+            const glm::vec4& plane = frustum.planes[p];
+            float distance = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w;
+            float reach = fabsf(plane.x) * bounds.extentX[i] + fabsf(plane.y) * bounds.extentY[i] + fabsf(plane.z) * bounds.extentZ[i];
+            inside = distance + reach >= 0.0f;
+        }
+        if (inside) out[written++] = (uint32_t)i;
+    }
+#endif
+    return written;
+}
+
+static size_t CullSphereBlock(const Frustum& frustum, const CullingSpheres& bounds, size_t begin, size_t end, uint32_t* out)
+{
+    size_t written = 0;
+#if SIMD_LANES > 1
+    Lanes planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        const glm::vec4& plane = frustum.planes[p];
+        planeX[p] = Splat(plane.x);
+        planeY[p] = Splat(plane.y);
+        planeZ[p] = Splat(plane.z);
+        planeW[p] = Splat(plane.w);
+    }
+    for (size_t i = begin; i < end; i += SIMD_LANES)
+    {
+        Lanes cx = Load(&bounds.centerX[i]), cy = Load(&bounds.centerY[i]), cz = Load(&bounds.centerZ[i]);
+        Lanes radius = Load(&bounds.radius[i]);
+        Lanes outside = Zero();
+        for (int p = 0; p < 6; ++p)
+        {
+            Lanes distance = Add(Add(Mul(planeX[p], cx), Mul(planeY[p], cy)), Add(Mul(planeZ[p], cz), planeW[p]));
+            outside = Or(outside, LessThanZero(Add(distance, radius)));
+        }
+        written = WriteVisible(~LaneMask(outside) & ((1u << SIMD_LANES) - 1u), i, end, out, written);
+    }
+#else
+    for (size_t i = begin; i < end; ++i)
+    {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; ++p)
+        {
+            const glm::vec4& plane = frustum.planes[p];
+            inside = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w + bounds.radius[i] >= 0.0f;
+        }
+        if (inside) out[written++] = (uint32_t)i;
+    }
+#endif
+    return written;
+}
+
+// Cull every block into its own stretch of a scratch buffer, then gather the stretches into visible
+template <typename CullBlock>
+static size_t CullInBlocks(size_t count, bool parallel, std::vector<uint32_t>& visible, CullBlock cullBlock)
+{
+    // The calling thread's scratch, named here so the workers all write to this one, not to their own
+    static thread_local std::vector<uint32_t> callerScratch;
+    std::vector<uint32_t>& scratch = callerScratch;
+    if (scratch.size() < PaddedCount(count)) scratch.resize(PaddedCount(count));
+    size_t blockCount = (count + CULLING_BLOCK_SIZE - 1) / CULLING_BLOCK_SIZE;
+    std::vector<size_t> written(blockCount), offsets(blockCount);
+
+    std::function<void(size_t, size_t)> cull = [&](size_t begin, size_t end) {
+        written[begin / CULLING_BLOCK_SIZE] = cullBlock(begin, end, &scratch[begin]);
+    };
+    if (parallel)
+        ParallelFor(count, CULLING_BLOCK_SIZE, cull);
+    else if (count > 0)
+        for (size_t begin = 0; begin < count; begin += CULLING_BLOCK_SIZE)
+            cull(begin, std::min(begin + CULLING_BLOCK_SIZE, count));
+
+    size_t total = 0;
+    for (size_t block = 0; block < blockCount; ++block)
+    {
+        offsets[block] = total;
+        total += written[block];
+    }
+    visible.resize(total);
+    std::function<void(size_t, size_t)> gather = [&](size_t begin, size_t end) {
+        for (size_t block = begin; block < end; ++block)
+            if (written[block] > 0)
+                memcpy(&visible[offsets[block]], &scratch[block * CULLING_BLOCK_SIZE], written[block] * sizeof(uint32_t));
+    };
+    if (parallel)
+        ParallelFor(blockCount, 1, gather);
+    else
+        gather(0, blockCount);
+    return total;
+}
+
+size_t CullAabbs(const Frustum& frustum, const CullingAabbs& bounds, std::vector<uint32_t>& visible, bool parallel)
+{
+    return CullInBlocks(bounds.count, parallel, visible, [&](size_t begin, size_t end, uint32_t* out) {
+        return CullAabbBlock(frustum, bounds, begin, end, out);
+    });
+}
+
+size_t CullSpheres(const Frustum& frustum, const CullingSpheres& bounds, std::vector<uint32_t>& visible, bool parallel)
+{
+    return CullInBlocks(bounds.count, parallel, visible, [&](size_t begin, size_t end, uint32_t* out) {
+        return CullSphereBlock(frustum, bounds, begin, end, out);
+    });
+}
@@ -0,0 +1,59 @@
+#ifndef __FrustumCulling_h__
+#define __FrustumCulling_h__
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Frustum culling on the CPU for scenes with many objects. Bounds are kept as a structure of arrays, so
+// one SIMD instruction tests a plane against 8 objects with AVX, or 4 with SSE; blocks of objects are
+// spread over the worker threads (see WorkerPool.h), and the result is the indices of the objects that
+// may be visible, in order.
+// Builds without SSE (non-x86 targets) fall back to testing one object at a time.
+
+// Bounds arrays are padded to a multiple of this, so the SIMD loops never need a scalar tail
+#define CULLING_PADDING 8
+
+// The six planes bounding the view, pointing inwards and normalized: a point p is inside a plane when
+// dot(plane.xyz, p) + plane.w >= 0. Left, right, bottom, top, near, far
+struct Frustum
+{
+    glm::vec4 planes[6];
+};
+
+// The frustum of a Projection * View matrix, in world space; with a Projection * View * Model matrix
+// the planes are in model space instead
+Frustum ExtractFrustum(const glm::mat4& viewProjection);
+
+// Axis aligned boxes as centres and half extents
+struct CullingAabbs
+{
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    size_t count = 0;
+};
+
+struct CullingSpheres
+{
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> radius;
+    size_t count = 0;
+};
+
+// Make room for count objects, keeping the first ones and the padding
+void ResizeCullingBounds(CullingAabbs& bounds, size_t count);
+void ResizeCullingBounds(CullingSpheres& bounds, size_t count);
+
+void SetCullingAabb(CullingAabbs& bounds, size_t index, const glm::vec3& low, const glm::vec3& high);
+void SetCullingSphere(CullingSpheres& bounds, size_t index, const glm::vec3& center, float radius);
+
+// The box around the box low to high once it has been transformed by matrix (Arvo's method)
+void TransformAabb(const glm::mat4& matrix, const glm::vec3& low, const glm::vec3& high, glm::vec3& transformedLow, glm::vec3& transformedHigh);
+
+// Fill visible with the indices of the objects touching the frustum, in ascending order, and return how
+// many there are. Objects are conservatively kept: a box outside the frustum near one of its corners may
+// pass. With parallel set, blocks of objects are culled on every worker thread
+size_t CullAabbs(const Frustum& frustum, const CullingAabbs& bounds, std::vector<uint32_t>& visible, bool parallel = true);
+size_t CullSpheres(const Frustum& frustum, const CullingSpheres& bounds, std::vector<uint32_t>& visible, bool parallel = true);
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef __GLObjects_h__
+#define __GLObjects_h__
+
+#include <GL/glew.h>
+
+// Owning handles for GL objects
+// Each one is just the GLuint name: no virtual calls and no reference count. They can be moved but not
+// copied, and delete their object when they go out of scope or are assigned over. Use get() to hand
+// the name to GL and release() to take back ownership of it.
+
+// Defined in ShaderLoader.cpp; programs also have reflection tables and cached shaders to clean up
+void DeleteShaderProgram(GLuint program);
+
+inline void DeleteBufferObject(GLuint buffer) { glDeleteBuffers(1, &buffer); }
+inline void DeleteVertexArrayObject(GLuint vertexArray) { glDeleteVertexArrays(1, &vertexArray); }
+inline void DeleteShaderObject(GLuint shader) { glDeleteShader(shader); }
+
+template <void (*Delete)(GLuint)>
+class GLObject
+{
+public:
+    GLObject() = default;
+    explicit GLObject(GLuint name) : name(name) {}
+    GLObject(GLObject&& other) noexcept : name(other.name) { other.name = 0; }
+    GLObject& operator=(GLObject&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset(other.name);
+            other.name = 0;
+        }
+        return *this;
+    }
+    GLObject(const GLObject&) = delete;
+    GLObject& operator=(const GLObject&) = delete;
+    ~GLObject() { if (name != 0) Delete(name); }
+
+    GLuint get() const { return name; }
+    explicit operator bool() const { return name != 0; }
+
+    // Give up ownership without deleting the object
+    GLuint release()
+    {
+        GLuint released = name;
+        name = 0;
+        return released;
+    }
+    // Delete the current object, if any, and take ownership of another
+    void reset(GLuint other = 0)
+    {
+        if (name != 0 && name != other) Delete(name);
+        name = other;
+    }
+
+private:
+    GLuint name = 0;
+};
+
+typedef GLObject<DeleteBufferObject> Buffer;
+typedef GLObject<DeleteVertexArrayObject> VertexArray;
+typedef GLObject<DeleteShaderObject> Shader;
+typedef GLObject<DeleteShaderProgram> Program;
+
+static_assert(sizeof(Buffer) == sizeof(GLuint), "GL object handles must be no bigger than the name they hold");
+
+inline Buffer CreateBuffer()
+{
+    GLuint buffer;
+    glCreateBuffers(1, &buffer);
+    return Buffer(buffer);
+}
+
+inline VertexArray CreateVertexArray()
+{
+    GLuint vertexArray;
+    glCreateVertexArrays(1, &vertexArray);
+    return VertexArray(vertexArray);
+}
+
+#endif
@@ -0,0 +1,981 @@
+#include <algorithm>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include "Data.h"
+#include "ErrorHandling.h"
+#include "Gltf.h"
+#include "IndexBuffer.h"
+#include "Json.h"
+#include "MappedFile.h"
+#include "VertexArrayCache.h"
+#include "VertexLayout.h"
+
+static const uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+static const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+static const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+// Occluders are the draws with the biggest bounds, as long as they fit in this many triangles between them
+static const size_t GLTF_MAX_OCCLUDERS = 32;
+static const size_t GLTF_OCCLUDER_TRIANGLES = 16384;
+
+static const char* const attributeNames[GLTF_ATTRIBUTE_COUNT] = {
+    "POSITION", "NORMAL", "TEXCOORD_0", "TANGENT", "TEXCOORD_1", "COLOR_0", "JOINTS_0", "WEIGHTS_0"
+};
+
+// The bytes of a file, either inside the packed archive or mapped for the length of the load
+struct GltfFile
+{
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+};
+
+struct GltfBufferView
+{
+    size_t buffer;
+    uint64_t offset;
+    uint64_t length;
+    uint32_t stride;  // 0 for tightly packed
+};
+
+struct GltfAccessor
+{
+    int32_t bufferView; // -1 for all zeros
+    uint64_t offset;
+    uint32_t componentType;
+    uint32_t components;
+    uint32_t count;
+    bool normalized;
+    const JsonValue* sparse;
+    int32_t repacked;   // index into the scene's buffers once repacked, else -1
+};
+
+// Where GL reads an attribute from; no padding, so batch keys can be hashed and compared as bytes
+struct GltfStream
+{
+    uint64_t offset;
+    uint32_t buffer;
+    uint32_t stride;
+    uint32_t componentType;
+    uint32_t components;
+    uint32_t normalized;
+    uint32_t padding;
+};
+
+// Everything a batch's vertex array holds, plus the primitive mode
+struct GltfBatchKey
+{
+    uint32_t mode;
+    uint32_t indexType;
+    uint32_t indexBuffer;
+    uint32_t attributeMask;
+    GltfStream attributes[GLTF_ATTRIBUTE_COUNT];
+};
+
+struct GltfPrimitive
+{
+    uint32_t batch;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t baseVertex;
+    int32_t material;
+    glm::vec3 low, high; // model space bounds
+    bool bounded;        // false if the file gave no bounds, and low and high take in everything
+    uint32_t positionAccessor;
+    int32_t indexAccessor; // -1 when unindexed
+};
+
+struct GltfLoader
+{
+    const char* filePath;
+    std::string directory;
+    JsonValue json;
+    std::vector<GltfFile> files; // the file itself and any external buffers
+    std::vector<std::vector<unsigned char>> decoded; // buffers embedded as data: URIs
+    std::vector<const unsigned char*> bufferData;
+    std::vector<uint64_t> bufferSizes;
+    std::vector<int32_t> uploads;         // index into the scene's buffers once a glTF buffer is uploaded, else -1
+    std::vector<uint64_t> uploadStarts;   // where in its glTF buffer the upload starts
+    std::vector<GltfBufferView> views;
+    std::vector<GltfAccessor> accessors;
+    std::vector<std::vector<GltfPrimitive>> meshes;
+    std::vector<GltfBatchKey> batchKeys;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> batchesByHash;
+};
+
+static bool GltfError(const GltfLoader& loader, const char* message)
+{
+    fprintf(stderr, "Unable to load %s: %s\n", loader.filePath, message);
+    return false;
+}
+
+static bool OpenGltfFile(const std::string& path, GltfFile& file)
+{
+    const void* packedData;
+    size_t packedSize;
+    if (findPackedFile(path.c_str(), &packedData, &packedSize))
+    {
+        file.data = (const unsigned char*)packedData;
+        file.size = packedSize;
+        file.mapped = false;
+        return true;
+    }
+    file.data = MapFile(path.c_str(), &file.size, true);
+    if (file.data == nullptr)
+        file.data = MapFile(DataPathToFilePath(path.c_str()).c_str(), &file.size, true);
+    file.mapped = file.data != nullptr;
+    return file.mapped;
+}
+
+static void CloseGltfFiles(GltfLoader& loader)
+{
+    for (GltfFile& file : loader.files)
+        if (file.mapped)
+            UnmapFile(file.data, file.size);
+    loader.files.clear();
+}
+
+static uint32_t ReadUint32(const unsigned char* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t ComponentSize(uint32_t componentType)
+{
+    switch (componentType)
+    {
+    case GL_BYTE: case GL_UNSIGNED_BYTE: return 1;
+    case GL_SHORT: case GL_UNSIGNED_SHORT: return 2;
+    case GL_UNSIGNED_INT: case GL_FLOAT: return 4;
+    default: return 0;
+    }
+}
+
+static uint32_t ComponentCount(const char* type)
+{
+    static const char* const types[] = { "SCALAR", "VEC2", "VEC3", "VEC4", "MAT2", "MAT3", "MAT4" };
+    static const uint32_t counts[] = { 1, 2, 3, 4, 4, 9, 16 };
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i)
+        if (strcmp(type, types[i]) == 0)
+            return counts[i];
+    return 0;
+}
+
+static int Base64Digit(char c)
+{
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+' || c == '-') return 62;
+    if (c == '/' || c == '_') return 63;
+    return -1;
+}
+
+static void DecodeBase64(const char* text, std::vector<unsigned char>& out)
+{
+    uint32_t bits = 0;
+    int bitCount = 0;
+    for (; *text != 0 && *text != '='; ++text)
+    {
+        int digit = Base64Digit(*text);
+        if (digit < 0) continue;
+        bits = bits << 6 | (uint32_t)digit;
+        bitCount += 6;
+        if (bitCount >= 8)
+        {
+            bitCount -= 8;
+            out.push_back((unsigned char)(bits >> bitCount));
+        }
+    }
+}
+
+// URIs of external files may escape characters, most often spaces
+static std::string DecodeUri(const char* uri)
+{
+    std::string path;
+    for (; *uri != 0; ++uri)
+    {
+        if (uri[0] == '%' && isxdigit((unsigned char)uri[1]) && isxdigit((unsigned char)uri[2]))
+        {
+            char hex[3] = { uri[1], uri[2], 0 };
+            path += (char)strtol(hex, nullptr, 16);
+            uri += 2;
+        }
+        else
+            path += *uri;
+    }
+    return path;
+}
+
+// Find the JSON and the binary chunk of a GLB, or take a .gltf as all JSON
+static bool ReadContainer(GltfLoader& loader, const GltfFile& file, const unsigned char** binary, uint64_t* binarySize)
+{
+    const char* text = (const char*)file.data;
+    size_t textSize = file.size;
+    *binary = nullptr;
+    *binarySize = 0;
+    if (file.size >= 12 && ReadUint32(file.data) == GLB_MAGIC)
+    {
+        uint32_t length = ReadUint32(file.data + 8);
+        if (ReadUint32(file.data + 4) != 2) return GltfError(loader, "only GLB version 2 is supported");
+        if (length > file.size || length < 20) return GltfError(loader, "GLB is truncated");
+        uint32_t jsonLength = ReadUint32(file.data + 12);
+        if (ReadUint32(file.data + 16) != GLB_CHUNK_JSON || jsonLength > length - 20)
+            return GltfError(loader, "GLB does not start with a JSON chunk");
+        text = (const char*)file.data + 20;
+        textSize = jsonLength;
+
+        uint64_t next = 20 + (((uint64_t)jsonLength + 3) & ~3ull);
+        if (next + 8 <= length && ReadUint32(file.data + next + 4) == GLB_CHUNK_BIN)
+        {
+            uint32_t binLength = ReadUint32(file.data + next);
+            if (binLength > length - next - 8) return GltfError(loader, "GLB binary chunk is truncated");
+            *binary = file.data + next + 8;
+            *binarySize = binLength;
+        }
+    }
+
+    std::string error;
+    if (!ParseJson(text, textSize, loader.json, error))
+        return GltfError(loader, error.c_str());
+    const char* version = JsonString(JsonMember(JsonMember(&loader.json, "asset"), "version"), "");
+    if (version[0] != '2')
+        return GltfError(loader, "not a glTF 2.0 asset");
+    return true;
+}
+
+static bool ReadBuffers(GltfLoader& loader, const unsigned char* binary, uint64_t binarySize)
+{
+    const JsonValue* buffers = JsonMember(&loader.json, "buffers");
+    for (size_t i = 0; i < JsonSize(buffers); ++i)
+    {
+        const JsonValue* buffer = JsonElement(buffers, i);
+        int64_t length = JsonInt(JsonMember(buffer, "byteLength"), -1);
+        const char* uri = JsonString(JsonMember(buffer, "uri"), nullptr);
+        const unsigned char* data = nullptr;
+        uint64_t size = 0;
+        if (uri == nullptr)
+        {
+            // Only the first buffer of a GLB may leave out its URI; it is the binary chunk
+            if (i != 0 || binary == nullptr) return GltfError(loader, "buffer has no data");
+            data = binary;
+            size = binarySize;
+        }
+        else if (strncmp(uri, "data:", 5) == 0)
+        {
+            const char* base64 = strstr(uri, ";base64,");
+            if (base64 == nullptr) return GltfError(loader, "data URI is not base64");
+            loader.decoded.emplace_back();
+            DecodeBase64(base64 + 8, loader.decoded.back());
+            data = loader.decoded.back().data();
+            size = loader.decoded.back().size();
+        }
+        else
+        {
+            GltfFile file;
+            if (!OpenGltfFile(loader.directory + DecodeUri(uri), file))
+            {
+                fprintf(stderr, "Unable to open %s%s\n", loader.directory.c_str(), uri);
+                return GltfError(loader, "missing buffer");
+            }
+            loader.files.push_back(file);
+            data = file.data;
+            size = file.size;
+        }
+        if (length < 0 || (uint64_t)length > size) return GltfError(loader, "buffer is shorter than its byteLength");
+        loader.bufferData.push_back(data);
+        loader.bufferSizes.push_back((uint64_t)length);
+        loader.uploads.push_back(-1);
+        loader.uploadStarts.push_back(0);
+    }
+    return true;
+}
+
+static bool ReadViewsAndAccessors(GltfLoader& loader)
+{
+    const JsonValue* views = JsonMember(&loader.json, "bufferViews");
+    for (size_t i = 0; i < JsonSize(views); ++i)
+    {
+        const JsonValue* view = JsonElement(views, i);
+        int64_t buffer = JsonInt(JsonMember(view, "buffer"), -1);
+        int64_t offset = JsonInt(JsonMember(view, "byteOffset"), 0);
+        int64_t length = JsonInt(JsonMember(view, "byteLength"), -1);
+        int64_t stride = JsonInt(JsonMember(view, "byteStride"), 0);
+        if (buffer < 0 || (size_t)buffer >= loader.bufferData.size() || offset < 0 || length <= 0
+            || (uint64_t)offset + (uint64_t)length > loader.bufferSizes[buffer] || stride < 0 || stride > 252)
+            return GltfError(loader, "buffer view is out of range");
+        loader.views.push_back({ (size_t)buffer, (uint64_t)offset, (uint64_t)length, (uint32_t)stride });
+    }
+
+    const JsonValue* accessors = JsonMember(&loader.json, "accessors");
+    for (size_t i = 0; i < JsonSize(accessors); ++i)
+    {
+        const JsonValue* accessor = JsonElement(accessors, i);
+        GltfAccessor a;
+        a.bufferView = (int32_t)JsonInt(JsonMember(accessor, "bufferView"), -1);
+        int64_t offset = JsonInt(JsonMember(accessor, "byteOffset"), 0);
+        int64_t count = JsonInt(JsonMember(accessor, "count"), 0);
+        a.componentType = (uint32_t)JsonInt(JsonMember(accessor, "componentType"), 0);
+        a.components = ComponentCount(JsonString(JsonMember(accessor, "type"), ""));
+        a.normalized = JsonBool(JsonMember(accessor, "normalized"), false);
+        a.sparse = JsonMember(accessor, "sparse");
+        a.repacked = -1;
+        if (ComponentSize(a.componentType) == 0 || a.components == 0 || count <= 0 || count > 0x7FFFFFFF || offset < 0
+            || a.bufferView >= (int32_t)loader.views.size())
+            return GltfError(loader, "malformed accessor");
+        a.offset = (uint64_t)offset;
+        a.count = (uint32_t)count;
+
+        if (a.bufferView >= 0)
+        {
+            const GltfBufferView& view = loader.views[a.bufferView];
+            uint64_t elementSize = (uint64_t)ComponentSize(a.componentType) * a.components;
+            uint64_t stride = view.stride != 0 ? view.stride : elementSize;
+            if (a.offset + stride * (a.count - 1) + elementSize > view.length)
+                return GltfError(loader, "accessor runs past its buffer view");
+        }
+        loader.accessors.push_back(a);
+    }
+    return true;
+}
+
+static GLuint UploadBuffer(GltfScene& scene, const void* data, size_t size)
+{
+    scene.buffers.push_back(CreateBuffer());
+    glNamedBufferStorage(scene.buffers.back().get(), (GLsizeiptr)size, data, 0);
+    return (GLuint)(scene.buffers.size() - 1);
+}
+
+// Upload a glTF buffer once, from the first to the last byte any accessor reads, so images stored
+// around the geometry stay out of GL; returns the index of the upload in the scene's buffers
+static uint32_t UploadGltfBuffer(GltfLoader& loader, size_t buffer, GltfScene& scene)
+{
+    if (loader.uploads[buffer] >= 0) return (uint32_t)loader.uploads[buffer];
+
+    uint64_t start = loader.bufferSizes[buffer], end = 0;
+    for (const GltfAccessor& a : loader.accessors)
+    {
+        if (a.bufferView < 0 || loader.views[a.bufferView].buffer != buffer) continue;
+        const GltfBufferView& view = loader.views[a.bufferView];
+        start = std::min(start, view.offset);
+        end = std::max(end, view.offset + view.length);
+    }
+    // Offsets into the upload keep the alignment they had in the file
+    start &= ~(uint64_t)15;
+    loader.uploads[buffer] = (int32_t)UploadBuffer(scene, loader.bufferData[buffer] + start, (size_t)(end - start));
+    loader.uploadStarts[buffer] = start;
+    scene.inPlaceBytes += (size_t)(end - start);
+    return (uint32_t)loader.uploads[buffer];
+}
+
+// Read an accessor GL cannot use in place into a tightly packed copy, applying any sparse substitution
+static bool RepackAccessor(GltfLoader& loader, GltfAccessor& a, GltfScene& scene)
+{
+    if (a.repacked >= 0) return true;
+
+    uint32_t elementSize = ComponentSize(a.componentType) * a.components;
+    std::vector<unsigned char> packed((size_t)a.count * elementSize, 0);
+    if (a.bufferView >= 0)
+    {
+        const GltfBufferView& view = loader.views[a.bufferView];
+        const unsigned char* source = loader.bufferData[view.buffer] + view.offset + a.offset;
+        uint32_t stride = view.stride != 0 ? view.stride : elementSize;
+        for (uint32_t i = 0; i < a.count; ++i)
+            memcpy(&packed[(size_t)i * elementSize], source + (size_t)i * stride, elementSize);
+    }
+
+    if (a.sparse != nullptr)
+    {
+        int64_t count = JsonInt(JsonMember(a.sparse, "count"), 0);
+        const JsonValue* indices = JsonMember(a.sparse, "indices");
+        const JsonValue* values = JsonMember(a.sparse, "values");
+        int64_t indexView = JsonInt(JsonMember(indices, "bufferView"), -1);
+        int64_t valueView = JsonInt(JsonMember(values, "bufferView"), -1);
+        uint64_t indexOffset = (uint64_t)JsonInt(JsonMember(indices, "byteOffset"), 0);
+        uint64_t valueOffset = (uint64_t)JsonInt(JsonMember(values, "byteOffset"), 0);
+        uint32_t indexSize = ComponentSize((uint32_t)JsonInt(JsonMember(indices, "componentType"), 0));
+        if (count <= 0 || count > a.count || indexView < 0 || (size_t)indexView >= loader.views.size()
+            || valueView < 0 || (size_t)valueView >= loader.views.size() || indexSize == 0 || indexSize == 3
+            || indexOffset + (uint64_t)count * indexSize > loader.views[indexView].length
+            || valueOffset + (uint64_t)count * elementSize > loader.views[valueView].length)
+            return GltfError(loader, "malformed sparse accessor");
+
+        const GltfBufferView& iv = loader.views[indexView];
+        const GltfBufferView& vv = loader.views[valueView];
+        const unsigned char* indexData = loader.bufferData[iv.buffer] + iv.offset + indexOffset;
+        const unsigned char* valueData = loader.bufferData[vv.buffer] + vv.offset + valueOffset;
+        for (int64_t i = 0; i < count; ++i)
+        {
+            uint32_t index = 0;
+            memcpy(&index, indexData + i * indexSize, indexSize);
+            if (index >= a.count) return GltfError(loader, "sparse accessor index is out of range");
+            memcpy(&packed[(size_t)index * elementSize], valueData + i * elementSize, elementSize);
+        }
+    }
+
+    a.repacked = (int32_t)UploadBuffer(scene, packed.data(), packed.size());
+    scene.repackedBytes += packed.size();
+    return true;
+}
+
+// Where GL should read an accessor from: its glTF buffer as uploaded if the layout allows, else a repacked copy
+static bool AccessorStream(GltfLoader& loader, uint32_t accessorIndex, GltfScene& scene, GltfStream& stream)
+{
+    GltfAccessor& a = loader.accessors[accessorIndex];
+    uint32_t componentSize = ComponentSize(a.componentType);
+    uint32_t elementSize = componentSize * a.components;
+    memset(&stream, 0, sizeof(stream));
+    stream.componentType = a.componentType;
+    stream.components = a.components;
+    stream.normalized = a.normalized;
+
+    if (a.bufferView >= 0 && a.sparse == nullptr)
+    {
+        const GltfBufferView& view = loader.views[a.bufferView];
+        uint32_t stride = view.stride != 0 ? view.stride : elementSize;
+        // glTF requires this, but a file breaking the rule is repacked rather than read misaligned
+        if ((view.offset + a.offset) % componentSize == 0 && stride % componentSize == 0)
+        {
+            stream.buffer = UploadGltfBuffer(loader, view.buffer, scene);
+            stream.offset = view.offset - loader.uploadStarts[view.buffer] + a.offset;
+            stream.stride = stride;
+            return true;
+        }
+    }
+
+    if (!RepackAccessor(loader, a, scene)) return false;
+    stream.buffer = (uint32_t)a.repacked;
+    stream.stride = elementSize;
+    return true;
+}
+
+// The largest index an accessor holds, read from wherever its data lives
+static uint32_t MaxIndex(const GltfLoader& loader, const GltfAccessor& a, const GltfStream& stream, const GltfScene& scene)
+{
+    uint32_t size = ComponentSize(a.componentType);
+    std::vector<unsigned char> copy;
+    const unsigned char* data;
+    if (a.repacked >= 0 && stream.buffer == (uint32_t)a.repacked)
+    {
+        // Only sparse or view-less index accessors end up here, which are rare; read the upload back
+        copy.resize((size_t)a.count * size);
+        glGetNamedBufferSubData(scene.buffers[a.repacked].get(), 0, (GLsizeiptr)copy.size(), copy.data());
+        data = copy.data();
+    }
+    else
+    {
+        const GltfBufferView& view = loader.views[a.bufferView];
+        data = loader.bufferData[view.buffer] + view.offset + a.offset;
+    }
+
+    uint32_t largest = 0;
+    for (uint32_t i = 0; i < a.count; ++i)
+    {
+        uint32_t index = 0;
+        memcpy(&index, data + (size_t)i * size, size);
+        largest = std::max(largest, index);
+    }
+    return largest;
+}
+
+static uint32_t FindBatch(GltfLoader& loader, const GltfBatchKey& key)
+{
+    uint64_t hash = 14695981039346656037ull;
+    const unsigned char* bytes = (const unsigned char*)&key;
+    for (size_t i = 0; i + 8 <= sizeof(key); i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = VertexLayoutHash(hash, word);
+    }
+
+    std::vector<uint32_t>& candidates = loader.batchesByHash[hash];
+    for (uint32_t batch : candidates)
+        if (memcmp(&loader.batchKeys[batch], &key, sizeof(key)) == 0)
+            return batch;
+    candidates.push_back((uint32_t)loader.batchKeys.size());
+    loader.batchKeys.push_back(key);
+    return candidates.back();
+}
+
+static bool ReadPrimitive(GltfLoader& loader, const JsonValue* json, GltfScene& scene, GltfPrimitive& primitive)
+{
+    const JsonValue* attributes = JsonMember(json, "attributes");
+    GltfBatchKey key;
+    memset(&key, 0, sizeof(key));
+    key.mode = (uint32_t)JsonInt(JsonMember(json, "mode"), GL_TRIANGLES);
+    if (key.mode > GL_TRIANGLE_FAN) return GltfError(loader, "unknown primitive mode");
+
+    primitive.material = (int32_t)JsonInt(JsonMember(json, "material"), -1);
+    if (primitive.material >= (int32_t)JsonSize(JsonMember(&loader.json, "materials")))
+        return GltfError(loader, "primitive refers to a material that does not exist");
+
+    uint32_t vertexCount = 0xFFFFFFFFu;
+    for (uint32_t location = 0; location < GLTF_ATTRIBUTE_COUNT; ++location)
+    {
+        int64_t accessor = JsonInt(JsonMember(attributes, attributeNames[location]), -1);
+        if (accessor < 0) continue;
+        if ((size_t)accessor >= loader.accessors.size()) return GltfError(loader, "attribute refers to an accessor that does not exist");
+        if (loader.accessors[accessor].components > 4) return GltfError(loader, "matrix attributes are not supported");
+        if (!AccessorStream(loader, (uint32_t)accessor, scene, key.attributes[location])) return false;
+        vertexCount = std::min(vertexCount, loader.accessors[accessor].count);
+        key.attributeMask |= 1u << location;
+    }
+    if ((key.attributeMask & 1u << GLTF_ATTRIBUTE_POSITION) == 0)
+        return GltfError(loader, "primitive has no positions");
+    const GltfStream& position = key.attributes[GLTF_ATTRIBUTE_POSITION];
+    if (position.componentType != GL_FLOAT || position.components != 3)
+        return GltfError(loader, "positions are not float triples");
+    // Position accessors are required to have bounds; a primitive without them is never culled
+    primitive.positionAccessor = (uint32_t)JsonInt(JsonMember(attributes, "POSITION"), -1);
+    const JsonValue* positionAccessor = JsonElement(JsonMember(&loader.json, "accessors"), primitive.positionAccessor);
+    const JsonValue* low = JsonMember(positionAccessor, "min");
+    const JsonValue* high = JsonMember(positionAccessor, "max");
+    primitive.bounded = JsonSize(low) == 3 && JsonSize(high) == 3;
+    for (int c = 0; c < 3; ++c)
+    {
+        primitive.low[c] = primitive.bounded ? (float)JsonNumber(JsonElement(low, c), 0.0) : -1e30f;
+        primitive.high[c] = primitive.bounded ? (float)JsonNumber(JsonElement(high, c), 0.0) : 1e30f;
+    }
+
+    int64_t indices = JsonInt(JsonMember(json, "indices"), -1);
+    primitive.indexAccessor = (int32_t)indices;
+    if (indices >= 0)
+    {
+        if ((size_t)indices >= loader.accessors.size()) return GltfError(loader, "indices refer to an accessor that does not exist");
+        const GltfAccessor& a = loader.accessors[indices];
+        if (a.components != 1 || (a.componentType != GL_UNSIGNED_BYTE && a.componentType != GL_UNSIGNED_SHORT && a.componentType != GL_UNSIGNED_INT))
+            return GltfError(loader, "indices are not unsigned integers");
+        // Index data is aligned to its type, so its offset in the upload is a whole number of indices
+        GltfStream indexStream;
+        if (!AccessorStream(loader, (uint32_t)indices, scene, indexStream)) return false;
+        if (MaxIndex(loader, a, indexStream, scene) >= vertexCount)
+            return GltfError(loader, "index is beyond the end of the vertices");
+        key.indexBuffer = indexStream.buffer;
+        key.indexType = a.componentType;
+        primitive.firstIndex = (uint32_t)(indexStream.offset / ComponentSize(a.componentType));
+        primitive.indexCount = a.count;
+    }
+    else
+    {
+        // Unindexed primitives are drawn through indices counting up, so they can join the indirect batches
+        std::vector<uint32_t> sequence(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; ++i) sequence[i] = i;
+        IndexData indexData;
+        BuildIndexData(sequence.data(), sequence.size(), false, indexData);
+        key.indexBuffer = UploadBuffer(scene, indexData.bytes.data(), indexData.bytes.size());
+        key.indexType = indexData.type;
+        scene.repackedBytes += indexData.bytes.size();
+        primitive.firstIndex = 0;
+        primitive.indexCount = vertexCount;
+    }
+
+    // However many whole vertices into its binding the positions start, every binding can move back by that
+    // many vertices while baseVertex moves forward to match; primitives whose bindings then line up share them
+    uint64_t firstVertex = position.offset / position.stride;
+    for (uint32_t location = 0; location < GLTF_ATTRIBUTE_COUNT; ++location)
+        if (key.attributeMask & 1u << location && key.attributes[location].offset < firstVertex * key.attributes[location].stride)
+            firstVertex = 0;
+    if (firstVertex > 0x7FFFFFFF) firstVertex = 0;
+    for (uint32_t location = 0; location < GLTF_ATTRIBUTE_COUNT; ++location)
+        if (key.attributeMask & 1u << location)
+            key.attributes[location].offset -= firstVertex * key.attributes[location].stride;
+    primitive.baseVertex = (int32_t)firstVertex;
+
+    primitive.batch = FindBatch(loader, key);
+    return true;
+}
+
+static void ReadMaterials(const GltfLoader& loader, GltfScene& scene)
+{
+    const JsonValue* materials = JsonMember(&loader.json, "materials");
+    scene.materials.resize(JsonSize(materials));
+    for (size_t i = 0; i < scene.materials.size(); ++i)
+    {
+        const JsonValue* material = JsonElement(materials, i);
+        const JsonValue* pbr = JsonMember(material, "pbrMetallicRoughness");
+        const JsonValue* baseColor = JsonMember(pbr, "baseColorFactor");
+        const JsonValue* emissive = JsonMember(material, "emissiveFactor");
+        GltfMaterial& m = scene.materials[i];
+        for (int c = 0; c < 4; ++c)
+            m.baseColorFactor[c] = (float)JsonNumber(JsonElement(baseColor, c), 1.0);
+        for (int c = 0; c < 3; ++c)
+            m.emissiveFactor[c] = (float)JsonNumber(JsonElement(emissive, c), 0.0);
+        m.metallicFactor = (float)JsonNumber(JsonMember(pbr, "metallicFactor"), 1.0);
+        m.roughnessFactor = (float)JsonNumber(JsonMember(pbr, "roughnessFactor"), 1.0);
+        m.alphaCutoff = (float)JsonNumber(JsonMember(material, "alphaCutoff"), 0.5);
+        m.normalScale = (float)JsonNumber(JsonMember(JsonMember(material, "normalTexture"), "scale"), 1.0);
+        m.occlusionStrength = (float)JsonNumber(JsonMember(JsonMember(material, "occlusionTexture"), "strength"), 1.0);
+        m.baseColorTexture = (int32_t)JsonInt(JsonMember(JsonMember(pbr, "baseColorTexture"), "index"), -1);
+        m.metallicRoughnessTexture = (int32_t)JsonInt(JsonMember(JsonMember(pbr, "metallicRoughnessTexture"), "index"), -1);
+        m.normalTexture = (int32_t)JsonInt(JsonMember(JsonMember(material, "normalTexture"), "index"), -1);
+        m.occlusionTexture = (int32_t)JsonInt(JsonMember(JsonMember(material, "occlusionTexture"), "index"), -1);
+        m.emissiveTexture = (int32_t)JsonInt(JsonMember(JsonMember(material, "emissiveTexture"), "index"), -1);
+        const char* alphaMode = JsonString(JsonMember(material, "alphaMode"), "OPAQUE");
+        m.alphaMode = strcmp(alphaMode, "MASK") == 0 ? GLTF_ALPHA_MASK : strcmp(alphaMode, "BLEND") == 0 ? GLTF_ALPHA_BLEND : GLTF_ALPHA_OPAQUE;
+        m.doubleSided = JsonBool(JsonMember(material, "doubleSided"), false);
+    }
+}
+
+static glm::mat4 NodeTransform(const JsonValue* node)
+{
+    glm::mat4 transform(1.0f);
+    const JsonValue* matrix = JsonMember(node, "matrix");
+    if (JsonSize(matrix) == 16)
+    {
+        // Column major, the same as glm
+        for (int i = 0; i < 16; ++i)
+            transform[i / 4][i % 4] = (float)JsonNumber(JsonElement(matrix, i), i % 5 == 0 ? 1.0 : 0.0);
+        return transform;
+    }
+
+    const JsonValue* t = JsonMember(node, "translation");
+    const JsonValue* r = JsonMember(node, "rotation");
+    const JsonValue* s = JsonMember(node, "scale");
+    float x = (float)JsonNumber(JsonElement(r, 0), 0.0), y = (float)JsonNumber(JsonElement(r, 1), 0.0);
+    float z = (float)JsonNumber(JsonElement(r, 2), 0.0), w = (float)JsonNumber(JsonElement(r, 3), 1.0);
+    // translation * rotation * scale, with the rotation written out from the unit quaternion
+    transform[0] = glm::vec4(1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w), 0);
+    transform[1] = glm::vec4(2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w), 0);
+    transform[2] = glm::vec4(2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y), 0);
+    for (int c = 0; c < 3; ++c)
+        transform[c] = transform[c] * (float)JsonNumber(JsonElement(s, c), 1.0);
+    transform[3] = glm::vec4((float)JsonNumber(JsonElement(t, 0), 0.0), (float)JsonNumber(JsonElement(t, 1), 0.0),
+        (float)JsonNumber(JsonElement(t, 2), 0.0), 1);
+    return transform;
+}
+
+// Fill in the nodes, and list the ones in the default scene with parents before their children
+static bool ReadNodes(const GltfLoader& loader, GltfScene& scene, std::vector<uint32_t>& order)
+{
+    const JsonValue* nodes = JsonMember(&loader.json, "nodes");
+    size_t meshCount = JsonSize(JsonMember(&loader.json, "meshes"));
+    scene.nodes.resize(JsonSize(nodes));
+    for (size_t i = 0; i < scene.nodes.size(); ++i)
+    {
+        GltfNode& node = scene.nodes[i];
+        node.local = NodeTransform(JsonElement(nodes, i));
+        node.world = node.local;
+        node.parent = -1;
+        node.mesh = (int32_t)JsonInt(JsonMember(JsonElement(nodes, i), "mesh"), -1);
+        if (node.mesh >= (int32_t)meshCount) return GltfError(loader, "node refers to a mesh that does not exist");
+    }
+    for (size_t i = 0; i < scene.nodes.size(); ++i)
+    {
+        const JsonValue* children = JsonMember(JsonElement(nodes, i), "children");
+        for (size_t c = 0; c < JsonSize(children); ++c)
+        {
+            int64_t child = JsonInt(JsonElement(children, c), -1);
+            if (child < 0 || (size_t)child >= scene.nodes.size() || scene.nodes[child].parent >= 0 || (size_t)child == i)
+                return GltfError(loader, "node hierarchy is not a tree");
+            scene.nodes[child].parent = (int32_t)i;
+        }
+    }
+
+    std::vector<uint32_t> roots;
+    const JsonValue* scenes = JsonMember(&loader.json, "scenes");
+    if (JsonSize(scenes) > 0)
+    {
+        const JsonValue* rootList = JsonMember(JsonElement(scenes, (size_t)JsonInt(JsonMember(&loader.json, "scene"), 0)), "nodes");
+        for (size_t i = 0; i < JsonSize(rootList); ++i)
+        {
+            int64_t root = JsonInt(JsonElement(rootList, i), -1);
+            if (root < 0 || (size_t)root >= scene.nodes.size() || scene.nodes[root].parent >= 0)
+                return GltfError(loader, "scene root is not a root node");
+            roots.push_back((uint32_t)root);
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < scene.nodes.size(); ++i)
+            if (scene.nodes[i].parent < 0)
+                roots.push_back(i);
+    }
+
+    // Depth first with an explicit stack; a cycle has no root, so it is never reached
+    std::vector<uint8_t> visited(scene.nodes.size(), 0);
+    std::vector<uint32_t> stack(roots.rbegin(), roots.rend());
+    while (!stack.empty())
+    {
+        uint32_t index = stack.back();
+        stack.pop_back();
+        if (visited[index]) continue;
+        visited[index] = 1;
+        GltfNode& node = scene.nodes[index];
+        if (node.parent >= 0)
+            node.world = scene.nodes[node.parent].world * node.local;
+        order.push_back(index);
+
+        const JsonValue* children = JsonMember(JsonElement(nodes, index), "children");
+        for (size_t c = JsonSize(children); c-- > 0;)
+            stack.push_back((uint32_t)JsonInt(JsonElement(children, c), 0));
+    }
+    return true;
+}
+
+// Where an accessor's elements are in the files as loaded, or null if it is sparse or has no buffer view
+static const unsigned char* AccessorData(const GltfLoader& loader, const GltfAccessor& a, size_t* stride)
+{
+    if (a.bufferView < 0 || a.sparse != nullptr) return nullptr;
+    const GltfBufferView& view = loader.views[a.bufferView];
+    *stride = view.stride != 0 ? view.stride : ComponentSize(a.componentType) * a.components;
+    return loader.bufferData[view.buffer] + view.offset + a.offset;
+}
+
+// Copy the opaque triangle draws with the biggest bounds into the scene's occluder mesh, in world space;
+// primitives holds each draw's primitive
+static void PickOccluders(const GltfLoader& loader, GltfScene& scene, const std::vector<const GltfPrimitive*>& primitives)
+{
+    std::vector<uint32_t> candidates;
+    for (uint32_t draw = 0; draw < scene.draws.size(); ++draw)
+    {
+        int32_t material = scene.draws[draw].material;
+        if (!primitives[draw]->bounded || loader.batchKeys[scene.draws[draw].batch].mode != GL_TRIANGLES
+            || (material >= 0 && scene.materials[material].alphaMode != GLTF_ALPHA_OPAQUE))
+            continue;
+        candidates.push_back(draw);
+    }
+    const CullingAabbs& bounds = scene.drawBounds;
+    std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) {
+        float areaA = bounds.extentX[a] * bounds.extentY[a] + bounds.extentY[a] * bounds.extentZ[a] + bounds.extentZ[a] * bounds.extentX[a];
+        float areaB = bounds.extentX[b] * bounds.extentY[b] + bounds.extentY[b] * bounds.extentZ[b] + bounds.extentZ[b] * bounds.extentX[b];
+        return areaA > areaB;
+    });
+
+    size_t picked = 0, triangles = 0;
+    for (uint32_t draw : candidates)
+    {
+        const GltfPrimitive& primitive = *primitives[draw];
+        if (picked == GLTF_MAX_OCCLUDERS) break;
+        if (triangles + primitive.indexCount / 3 > GLTF_OCCLUDER_TRIANGLES) continue;
+        const GltfAccessor& positionAccessor = loader.accessors[primitive.positionAccessor];
+        size_t positionStride, indexSize = 0;
+        const unsigned char* positions = AccessorData(loader, positionAccessor, &positionStride);
+        const unsigned char* indices = primitive.indexAccessor >= 0 ? AccessorData(loader, loader.accessors[primitive.indexAccessor], &indexSize) : nullptr;
+        if (positions == nullptr || (primitive.indexAccessor >= 0 && indices == nullptr)) continue;
+
+        const glm::mat4& world = scene.nodes[scene.draws[draw].node].world;
+        uint32_t firstVertex = (uint32_t)(scene.occluderPositions.size() / 3);
+        for (uint32_t v = 0; v < positionAccessor.count; ++v)
+        {
+            float p[3];
+            memcpy(p, positions + (size_t)v * positionStride, sizeof(p));
+            glm::vec4 position = world * glm::vec4(p[0], p[1], p[2], 1.0f);
+            scene.occluderPositions.push_back(position.x);
+            scene.occluderPositions.push_back(position.y);
+            scene.occluderPositions.push_back(position.z);
+        }
+        for (uint32_t i = 0; i < primitive.indexCount / 3 * 3; ++i)
+        {
+            uint32_t index = i;
+            if (indices != nullptr)
+            {
+                index = 0;
+                memcpy(&index, indices + (size_t)i * indexSize, indexSize);
+            }
+            scene.occluderIndices.push_back(firstVertex + index);
+        }
+        triangles += primitive.indexCount / 3;
+        ++picked;
+    }
+}
+
+static void CreateBatchVertexArray(const GltfBatchKey& key, GltfScene& scene, GltfBatch& batch)
+{
+    batch.vertexArray = CreateVertexArray();
+    GLuint vertexArray = batch.vertexArray.get();
+    for (GLuint location = 0; location < GLTF_ATTRIBUTE_COUNT; ++location)
+    {
+        if ((key.attributeMask & 1u << location) == 0) continue;
+        const GltfStream& stream = key.attributes[location];
+        glEnableVertexArrayAttrib(vertexArray, location);
+        glVertexArrayAttribBinding(vertexArray, location, location);
+        if (location == GLTF_ATTRIBUTE_JOINTS_0)
+            glVertexArrayAttribIFormat(vertexArray, location, (GLint)stream.components, stream.componentType, 0);
+        else
+            glVertexArrayAttribFormat(vertexArray, location, (GLint)stream.components, stream.componentType, stream.normalized ? GL_TRUE : GL_FALSE, 0);
+        glVertexArrayVertexBuffer(vertexArray, location, scene.buffers[stream.buffer].get(), (GLintptr)stream.offset, (GLsizei)stream.stride);
+    }
+
+    // Divisor 1 makes the draw's baseInstance pick its matrix, with no shader extensions needed
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        GLuint location = GLTF_DRAW_MATRIX_LOCATION + column;
+        glEnableVertexArrayAttrib(vertexArray, location);
+        glVertexArrayAttribBinding(vertexArray, location, GLTF_DRAW_MATRIX_BINDING);
+        glVertexArrayAttribFormat(vertexArray, location, 4, GL_FLOAT, GL_FALSE, column * sizeof(glm::vec4));
+    }
+    glVertexArrayVertexBuffer(vertexArray, GLTF_DRAW_MATRIX_BINDING, scene.drawMatrixBuffer.get(), 0, sizeof(glm::mat4));
+    glVertexArrayBindingDivisor(vertexArray, GLTF_DRAW_MATRIX_BINDING, 1);
+    glVertexArrayElementBuffer(vertexArray, scene.buffers[key.indexBuffer].get());
+}
+
+static bool BuildScene(GltfLoader& loader, GltfScene& scene)
+{
+    ReadMaterials(loader, scene);
+    std::vector<uint32_t> order;
+    if (!ReadNodes(loader, scene, order)) return false;
+
+    // Only meshes the scene draws are uploaded
+    const JsonValue* meshes = JsonMember(&loader.json, "meshes");
+    loader.meshes.resize(JsonSize(meshes));
+    std::vector<uint8_t> meshRead(loader.meshes.size(), 0);
+    struct PendingDraw { uint32_t batch; uint32_t node; const GltfPrimitive* primitive; };
+    std::vector<PendingDraw> pending;
+    for (uint32_t index : order)
+    {
+        int32_t mesh = scene.nodes[index].mesh;
+        if (mesh < 0) continue;
+        if (!meshRead[mesh])
+        {
+            meshRead[mesh] = 1;
+            const JsonValue* primitives = JsonMember(JsonElement(meshes, mesh), "primitives");
+            loader.meshes[mesh].resize(JsonSize(primitives));
+            for (size_t p = 0; p < loader.meshes[mesh].size(); ++p)
+                if (!ReadPrimitive(loader, JsonElement(primitives, p), scene, loader.meshes[mesh][p]))
+                    return false;
+        }
+        for (const GltfPrimitive& primitive : loader.meshes[mesh])
+            pending.push_back({ primitive.batch, index, &primitive });
+    }
+
+    // Commands are grouped by batch, so each batch is one contiguous range of the command buffer
+    std::stable_sort(pending.begin(), pending.end(), [](const PendingDraw& a, const PendingDraw& b) { return a.batch < b.batch; });
+    scene.batches.resize(loader.batchKeys.size());
+    ResizeCullingBounds(scene.drawBounds, pending.size());
+    std::vector<glm::mat4> matrices;
+    std::vector<const GltfPrimitive*> drawPrimitives;
+    for (const PendingDraw& draw : pending)
+    {
+        GltfBatch& batch = scene.batches[draw.batch];
+        if (batch.commandCount == 0)
+            batch.firstCommand = (uint32_t)scene.commands.size();
+        ++batch.commandCount;
+        DrawElementsIndirectCommand command = {
+            draw.primitive->indexCount,
+            1,
+            draw.primitive->firstIndex,
+            draw.primitive->baseVertex,
+            (GLuint)scene.commands.size()
+        };
+        scene.commands.push_back(command);
+        scene.draws.push_back({ draw.node, draw.primitive->material, draw.batch });
+        matrices.push_back(scene.nodes[draw.node].world);
+        glm::vec3 low, high;
+        TransformAabb(scene.nodes[draw.node].world, draw.primitive->low, draw.primitive->high, low, high);
+        SetCullingAabb(scene.drawBounds, scene.draws.size() - 1, low, high);
+        drawPrimitives.push_back(draw.primitive);
+    }
+    if (scene.commands.empty()) return true;
+    PickOccluders(loader, scene, drawPrimitives);
+
+    scene.commandBuffer = CreateBuffer();
+    glNamedBufferStorage(scene.commandBuffer.get(), scene.commands.size() * sizeof(DrawElementsIndirectCommand), scene.commands.data(), GL_DYNAMIC_STORAGE_BIT);
+    scene.drawMatrixBuffer = CreateBuffer();
+    glNamedBufferStorage(scene.drawMatrixBuffer.get(), matrices.size() * sizeof(glm::mat4), matrices.data(), 0);
+    for (size_t i = 0; i < scene.batches.size(); ++i)
+    {
+        GltfBatch& batch = scene.batches[i];
+        batch.mode = loader.batchKeys[i].mode;
+        batch.indexType = loader.batchKeys[i].indexType;
+        batch.firstDrawnCommand = batch.firstCommand;
+        batch.drawnCommandCount = batch.commandCount;
+        if (batch.commandCount > 0)
+            CreateBatchVertexArray(loader.batchKeys[i], scene, batch);
+    }
+    return true;
+}
+
+bool LoadGltf(const char* filePath, GltfScene& scene)
+{
+    GltfLoader loader;
+    loader.filePath = filePath;
+    const char* slash = std::max(strrchr(filePath, '/'), strrchr(filePath, '\\'));
+    if (slash != nullptr)
+        loader.directory.assign(filePath, slash + 1);
+
+    loader.files.emplace_back();
+    if (!OpenGltfFile(filePath, loader.files.back()))
+    {
+        fprintf(stderr, "Unable to open %s\n", filePath);
+        return false;
+    }
+
+    scene = GltfScene();
+    err_checkGL("Before loading glTF");
+    const unsigned char* binary;
+    uint64_t binarySize;
+    GltfFile file = loader.files.back();
+    bool loaded = ReadContainer(loader, file, &binary, &binarySize)
+        && ReadBuffers(loader, binary, binarySize)
+        && ReadViewsAndAccessors(loader)
+        && BuildScene(loader, scene);
+    // The uploads have all been handed the mapped data by now
+    CloseGltfFiles(loader);
+    if (!loaded)
+    {
+        scene = GltfScene();
+        return false;
+    }
+    err_checkGL("Loading glTF");
+    return true;
+}
+
+bool IsGltfPath(const char* filePath)
+{
+    const char* extension = strrchr(filePath, '.');
+    if (extension == nullptr) return false;
+    std::string lower(extension);
+    for (char& c : lower) c = (char)tolower((unsigned char)c);
+    return lower == ".gltf" || lower == ".glb";
+}
+
+void CullGltfScene(GltfScene& scene, const glm::mat4& viewProjection)
+{
+    if (scene.commands.empty()) return;
+    CullAabbs(ExtractFrustum(viewProjection), scene.drawBounds, scene.visibleDraws);
+    if (!scene.occlusion.levels.empty() && !scene.occluderIndices.empty())
+    {
+        BeginOcclusionFrame(scene.occlusion, viewProjection);
+        AddOccluder(scene.occlusion, glm::mat4(1.0f), scene.occluderPositions.data(), scene.occluderPositions.size() / 3, 3 * sizeof(float),
+            scene.occluderIndices.data(), scene.occluderIndices.size());
+        RasterizeOccluders(scene.occlusion);
+        CullOccludedAabbs(scene.occlusion, scene.drawBounds, scene.visibleDraws);
+    }
+
+    // Commands are grouped by batch and the visible draws come in order, so each batch's survivors
+    // stay together at the front of the buffer
+    for (GltfBatch& batch : scene.batches)
+        batch.drawnCommandCount = 0;
+    scene.drawnCommands.clear();
+    for (uint32_t draw : scene.visibleDraws)
+    {
+        GltfBatch& batch = scene.batches[scene.draws[draw].batch];
+        if (batch.drawnCommandCount == 0)
+            batch.firstDrawnCommand = (uint32_t)scene.drawnCommands.size();
+        ++batch.drawnCommandCount;
+        scene.drawnCommands.push_back(scene.commands[draw]);
+    }
+    if (!scene.drawnCommands.empty())
+        glNamedBufferSubData(scene.commandBuffer.get(), 0, scene.drawnCommands.size() * sizeof(DrawElementsIndirectCommand), scene.drawnCommands.data());
+}
+
+void DrawGltfScene(const GltfScene& scene)
+{
+    if (scene.commands.empty()) return;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, scene.commandBuffer.get());
+    for (const GltfBatch& batch : scene.batches)
+    {
+        if (batch.drawnCommandCount == 0) continue;
+        BindVertexArray(batch.vertexArray.get());
+        glMultiDrawElementsIndirect(batch.mode, batch.indexType,
+            (const void*)(batch.firstDrawnCommand * sizeof(DrawElementsIndirectCommand)),
+            (GLsizei)batch.drawnCommandCount, sizeof(DrawElementsIndirectCommand));
+    }
+}
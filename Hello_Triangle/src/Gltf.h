@@ -0,0 +1,126 @@
+#ifndef __Gltf_h__
+#define __Gltf_h__
+
+#include <stdint.h>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "DrawCommands.h"
+#include "FrustumCulling.h"
+#include "GLObjects.h"
+#include "OcclusionCulling.h"
+
+// glTF 2.0 scenes (.gltf with its buffers, or .glb) loaded straight into GL buffers
+// Every buffer that holds vertices or indices is uploaded once, from the mapped file, as it is; primitives
+// then read it in place through vertex array bindings with their view's and accessor's offsets and stride.
+// Only accessors GL cannot read in place (sparse ones, or ones with no buffer view) are repacked.
+// Primitives whose data differs only by a whole number of vertices and indices share a batch,
+// drawn with one glMultiDrawElementsIndirect; the differences become baseVertex and firstIndex.
+
+// Attribute locations glTF attributes are read at; the first three match ObjVertexLayout
+#define GLTF_ATTRIBUTE_POSITION 0
+#define GLTF_ATTRIBUTE_NORMAL 1
+#define GLTF_ATTRIBUTE_TEXCOORD_0 2
+#define GLTF_ATTRIBUTE_TANGENT 3
+#define GLTF_ATTRIBUTE_TEXCOORD_1 4
+#define GLTF_ATTRIBUTE_COLOR_0 5
+#define GLTF_ATTRIBUTE_JOINTS_0 6  // an integer input (uvec4)
+#define GLTF_ATTRIBUTE_WEIGHTS_0 7
+#define GLTF_ATTRIBUTE_COUNT 8
+// The world matrix of the node a draw belongs to, one column per location from here on, read per
+// instance so each command's baseInstance picks its draw's matrix
+#define GLTF_DRAW_MATRIX_LOCATION 8
+#define GLTF_DRAW_MATRIX_BINDING 15
+
+#define GLTF_ALPHA_OPAQUE 0
+#define GLTF_ALPHA_MASK 1
+#define GLTF_ALPHA_BLEND 2
+
+// Texture indices refer to the file's textures array, or are -1; images are not loaded here
+struct GltfMaterial
+{
+    glm::vec4 baseColorFactor;
+    glm::vec3 emissiveFactor;
+    float metallicFactor;
+    float roughnessFactor;
+    float alphaCutoff;
+    float normalScale;
+    float occlusionStrength;
+    int32_t baseColorTexture;
+    int32_t metallicRoughnessTexture;
+    int32_t normalTexture;
+    int32_t occlusionTexture;
+    int32_t emissiveTexture;
+    uint32_t alphaMode;
+    uint32_t doubleSided;
+};
+
+// In file order; parent is -1 for roots, mesh is -1 for nodes without one
+struct GltfNode
+{
+    glm::mat4 local;
+    glm::mat4 world;
+    int32_t parent;
+    int32_t mesh;
+};
+
+// Primitives that share buffers, formats and primitive mode
+struct GltfBatch
+{
+    VertexArray vertexArray;
+    GLenum mode = GL_TRIANGLES;
+    GLenum indexType = GL_UNSIGNED_INT;
+    uint32_t firstCommand = 0;
+    uint32_t commandCount = 0;
+    // The part of the command buffer drawn: every command until the scene is culled, then the visible ones
+    uint32_t firstDrawnCommand = 0;
+    uint32_t drawnCommandCount = 0;
+};
+
+// One primitive of one node, in step with the scene's commands; a command's baseInstance is its index
+struct GltfDraw
+{
+    uint32_t node;
+    int32_t material; // -1 for the default material
+    uint32_t batch;
+};
+
+struct GltfScene
+{
+    std::vector<Buffer> buffers;     // uploaded glTF buffers and repacked accessors
+    std::vector<GltfMaterial> materials;
+    std::vector<GltfNode> nodes;
+    std::vector<GltfBatch> batches;
+    std::vector<DrawElementsIndirectCommand> commands; // grouped by batch
+    std::vector<GltfDraw> draws;
+    Buffer commandBuffer;
+    Buffer drawMatrixBuffer;         // a mat4 per draw
+    CullingAabbs drawBounds;         // a world space box per draw
+    std::vector<uint32_t> visibleDraws;                     // from the last CullGltfScene
+    std::vector<DrawElementsIndirectCommand> drawnCommands; // their commands, as uploaded
+    std::vector<float> occluderPositions; // the biggest opaque draws in world space, x, y, z each
+    std::vector<uint32_t> occluderIndices;
+    OcclusionBuffer occlusion;            // occlusion culling is off until it is given a size
+    size_t inPlaceBytes = 0;         // uploaded as the file has them
+    size_t repackedBytes = 0;
+};
+
+// Load a glTF or GLB file, found the same way as loadFile; buffers a .gltf refers to are looked up
+// next to it. The nodes of the default scene are drawn, each with its world transform.
+// Returns false, having reported why, if the file is missing or malformed
+bool LoadGltf(const char* filePath, GltfScene& scene);
+
+// Whether a path names a glTF or GLB file, by its extension
+bool IsGltfPath(const char* filePath);
+
+// Keep only the draws whose bounds touch the frustum of viewProjection in the command buffer, ready for
+// the next DrawGltfScene. Bounds are in the glTF world space, so viewProjection is Projection * View * Model
+// for a scene placed by Model. Once the scene's occlusion buffer has been sized, draws hidden behind its
+// occluders are dropped as well
+void CullGltfScene(GltfScene& scene, const glm::mat4& viewProjection);
+
+// Draw every batch of a scene, one glMultiDrawElementsIndirect each
+// Vertex arrays are bound with BindVertexArray; bind 0 before destroying a scene that has been drawn
+void DrawGltfScene(const GltfScene& scene);
+
+#endif
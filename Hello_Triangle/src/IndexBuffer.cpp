@@ -0,0 +1,174 @@
+#include <algorithm>
+#include "IndexBuffer.h"
+
+GLenum SelectIndexType(uint32_t largestIndex)
+{
+    if (largestIndex < 0xFFu) return GL_UNSIGNED_BYTE;
+    if (largestIndex < 0xFFFFu) return GL_UNSIGNED_SHORT;
+    return GL_UNSIGNED_INT;
+}
+
+size_t IndexTypeSize(GLenum type)
+{
+    switch (type)
+    {
+    case GL_UNSIGNED_BYTE: return 1;
+    case GL_UNSIGNED_SHORT: return 2;
+    default: return 4;
+    }
+}
+
+// A directed edge of a triangle, and the triangle's third vertex
+struct StripEdge
+{
+    uint64_t key; // from << 32 | to
+    uint32_t triangle;
+    uint32_t opposite;
+
+    bool operator<(const StripEdge& other) const { return key < other.key; }
+};
+
+static uint64_t EdgeKey(uint32_t from, uint32_t to)
+{
+    return (uint64_t)from << 32 | to;
+}
+
+// An unused triangle with the edge from -> to, or -1
+static int64_t FindTriangle(const std::vector<StripEdge>& edges, const std::vector<bool>& used, uint32_t from, uint32_t to, uint32_t& opposite)
+{
+    StripEdge probe = { EdgeKey(from, to), 0, 0 };
+    for (std::vector<StripEdge>::const_iterator edge = std::lower_bound(edges.begin(), edges.end(), probe);
+         edge != edges.end() && edge->key == probe.key; ++edge)
+    {
+        if (!used[edge->triangle])
+        {
+            opposite = edge->opposite;
+            return edge->triangle;
+        }
+    }
+    return -1;
+}
+
+size_t ConvertToStrips(const uint32_t* indices, size_t indexCount, std::vector<uint32_t>& strips)
+{
+    size_t triangleCount = indexCount / 3;
+    std::vector<StripEdge> edges;
+    edges.reserve(indexCount);
+    std::vector<bool> used(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        const uint32_t* v = indices + t * 3;
+        if (v[0] == v[1] || v[1] == v[2] || v[2] == v[0])
+        {
+            used[t] = true;
+            continue;
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            StripEdge edge = { EdgeKey(v[k], v[(k + 1) % 3]), (uint32_t)t, v[(k + 2) % 3] };
+            edges.push_back(edge);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    strips.clear();
+    for (size_t start = 0; start < triangleCount; ++start)
+    {
+        if (used[start]) continue;
+        used[start] = true;
+
+        // Begin with the rotation that lets a second triangle follow: it needs the edge c -> b
+        const uint32_t* v = indices + start * 3;
+        int rotation = 0;
+        uint32_t opposite;
+        for (int r = 0; r < 3; ++r)
+        {
+            if (FindTriangle(edges, used, v[(r + 2) % 3], v[(r + 1) % 3], opposite) >= 0)
+            {
+                rotation = r;
+                break;
+            }
+        }
+
+        if (!strips.empty()) strips.push_back(INDEX_RESTART);
+        size_t first = strips.size();
+        for (int k = 0; k < 3; ++k)
+            strips.push_back(v[(rotation + k) % 3]);
+
+        // Triangle k of a strip is (k, k+1, k+2) when k is even and (k+1, k, k+2) when odd, so the next
+        // triangle has to share the last two vertices in the order that keeps it facing the same way
+        for (size_t k = 1;; ++k)
+        {
+            uint32_t a = strips[first + k], b = strips[first + k + 1];
+            int64_t next = k % 2 == 0 ? FindTriangle(edges, used, a, b, opposite) : FindTriangle(edges, used, b, a, opposite);
+            if (next < 0) break;
+            used[next] = true;
+            strips.push_back(opposite);
+        }
+    }
+    return strips.size();
+}
+
+template <typename Index>
+static void PackIndices(const uint32_t* indices, size_t indexCount, std::vector<uint8_t>& bytes)
+{
+    bytes.resize(indexCount * sizeof(Index));
+    Index* packed = (Index*)bytes.data();
+    for (size_t i = 0; i < indexCount; ++i)
+        packed[i] = indices[i] == INDEX_RESTART ? (Index)~(Index)0 : (Index)indices[i];
+}
+
+void BuildIndexData(const uint32_t* indices, size_t indexCount, bool allowStrips, IndexData& data)
+{
+    std::vector<IndexRange> ranges(1);
+    ranges[0].firstIndex = 0;
+    ranges[0].count = (GLuint)indexCount;
+    BuildIndexData(indices, ranges, allowStrips, data);
+}
+
+void BuildIndexData(const uint32_t* indices, std::vector<IndexRange>& ranges, bool allowStrips, IndexData& data)
+{
+    uint32_t largest = 0;
+    size_t listCount = 0;
+    for (const IndexRange& range : ranges)
+    {
+        for (GLuint i = 0; i < range.count; ++i)
+            largest = std::max(largest, indices[range.firstIndex + i]);
+        listCount += range.count;
+    }
+
+    // Every list one after another, as given or as strips
+    std::vector<uint32_t> packed, strips;
+    std::vector<IndexRange> packedRanges(ranges.size());
+    packed.reserve(listCount);
+    for (size_t r = 0; r < ranges.size(); ++r)
+    {
+        packedRanges[r].firstIndex = (GLuint)packed.size();
+        if (allowStrips)
+        {
+            ConvertToStrips(indices + ranges[r].firstIndex, ranges[r].count, strips);
+            packed.insert(packed.end(), strips.begin(), strips.end());
+        }
+        else
+        {
+            packed.insert(packed.end(), indices + ranges[r].firstIndex, indices + ranges[r].firstIndex + ranges[r].count);
+        }
+        packedRanges[r].count = (GLuint)packed.size() - packedRanges[r].firstIndex;
+    }
+    if (allowStrips && packed.size() >= listCount)
+    {
+        BuildIndexData(indices, ranges, false, data);
+        return;
+    }
+
+    data.mode = allowStrips ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+    data.type = SelectIndexType(largest);
+    data.count = (GLuint)packed.size();
+    switch (data.type)
+    {
+    case GL_UNSIGNED_BYTE: PackIndices<uint8_t>(packed.data(), packed.size(), data.bytes); break;
+    case GL_UNSIGNED_SHORT: PackIndices<uint16_t>(packed.data(), packed.size(), data.bytes); break;
+    default: PackIndices<uint32_t>(packed.data(), packed.size(), data.bytes); break;
+    }
+    ranges.swap(packedRanges);
+}
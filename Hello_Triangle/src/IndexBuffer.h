@@ -0,0 +1,48 @@
+#ifndef __IndexBuffer_h__
+#define __IndexBuffer_h__
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <GL/glew.h>
+
+// Element buffers in the narrowest index type that holds a mesh's indices, optionally as triangle strips.
+// Strips are separated by primitive restart: the largest value of the index type ends one strip, which GL
+// does for every index type once GL_PRIMITIVE_RESTART_FIXED_INDEX is enabled. Enable it once at startup;
+// the types chosen here never leave that value to a real vertex, so lists draw the same either way.
+
+// Marks the end of a strip in the 32 bit indices ConvertToStrips returns
+#define INDEX_RESTART 0xFFFFFFFFu
+
+struct IndexData
+{
+    std::vector<uint8_t> bytes; // ready for glNamedBufferData
+    GLenum type;                // GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLenum mode;                // GL_TRIANGLES, or GL_TRIANGLE_STRIP with restarts
+    GLuint count;               // indices, restarts included: the draw command's count
+};
+
+// A run of indices drawn by one command
+struct IndexRange
+{
+    GLuint firstIndex;
+    GLuint count;
+};
+
+// The narrowest type whose restart value is above largestIndex
+GLenum SelectIndexType(uint32_t largestIndex);
+
+// 1, 2 or 4
+size_t IndexTypeSize(GLenum type);
+
+// Convert a triangle list to strips of the same triangles, facing the same way, with INDEX_RESTART between
+// strips. Triangles are taken in the list's order where no strip continues, so a cache optimized order
+// mostly survives; degenerate triangles are dropped. Returns the strip index count.
+size_t ConvertToStrips(const uint32_t* indices, size_t indexCount, std::vector<uint32_t>& strips);
+
+// Pack a triangle list into data; with allowStrips, strips are used where they come out shorter than the list
+void BuildIndexData(const uint32_t* indices, size_t indexCount, bool allowStrips, IndexData& data);
+// Pack several triangle lists into one buffer, such as a mesh's levels of detail. ranges says where each list
+// is in indices, and is updated to where it ended up in data. Either every list becomes strips or none does
+void BuildIndexData(const uint32_t* indices, std::vector<IndexRange>& ranges, bool allowStrips, IndexData& data);
+
+#endif
@@ -0,0 +1,281 @@
+#include <stdlib.h>
+#include <string.h>
+#include "Json.h"
+
+// Deep enough for any real document, shallow enough that hostile nesting cannot exhaust the stack
+static const int MAX_DEPTH = 256;
+
+struct JsonParser
+{
+    const char* p;
+    const char* end;
+    const char* begin;
+    std::string* error;
+};
+
+static bool JsonFail(JsonParser& parser, const char* message)
+{
+    if (parser.error->empty())
+        *parser.error = std::string(message) + " at byte " + std::to_string(parser.p - parser.begin);
+    return false;
+}
+
+static void SkipWhitespace(JsonParser& parser)
+{
+    while (parser.p < parser.end && (*parser.p == ' ' || *parser.p == '\t' || *parser.p == '\n' || *parser.p == '\r'))
+        ++parser.p;
+}
+
+static bool Expect(JsonParser& parser, const char* literal)
+{
+    size_t length = strlen(literal);
+    if ((size_t)(parser.end - parser.p) < length || memcmp(parser.p, literal, length) != 0)
+        return JsonFail(parser, "Unexpected token");
+    parser.p += length;
+    return true;
+}
+
+static int HexDigit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool ParseHex4(JsonParser& parser, uint32_t* codePoint)
+{
+    if (parser.end - parser.p < 4) return JsonFail(parser, "Truncated \\u escape");
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        int digit = HexDigit(parser.p[i]);
+        if (digit < 0) return JsonFail(parser, "Bad \\u escape");
+        value = value << 4 | (uint32_t)digit;
+    }
+    parser.p += 4;
+    *codePoint = value;
+    return true;
+}
+
+static void AppendUtf8(std::string& out, uint32_t codePoint)
+{
+    if (codePoint < 0x80)
+        out += (char)codePoint;
+    else if (codePoint < 0x800)
+    {
+        out += (char)(0xC0 | codePoint >> 6);
+        out += (char)(0x80 | (codePoint & 0x3F));
+    }
+    else if (codePoint < 0x10000)
+    {
+        out += (char)(0xE0 | codePoint >> 12);
+        out += (char)(0x80 | (codePoint >> 6 & 0x3F));
+        out += (char)(0x80 | (codePoint & 0x3F));
+    }
+    else
+    {
+        out += (char)(0xF0 | codePoint >> 18);
+        out += (char)(0x80 | (codePoint >> 12 & 0x3F));
+        out += (char)(0x80 | (codePoint >> 6 & 0x3F));
+        out += (char)(0x80 | (codePoint & 0x3F));
+    }
+}
+
+static bool ParseString(JsonParser& parser, std::string& out)
+{
+    ++parser.p; // opening quote
+    out.clear();
+    while (parser.p < parser.end)
+    {
+        // Copy runs without escapes in one go
+        const char* run = parser.p;
+        while (parser.p < parser.end && *parser.p != '"' && *parser.p != '\\' && (unsigned char)*parser.p >= 0x20)
+            ++parser.p;
+        out.append(run, parser.p);
+        if (parser.p == parser.end) break;
+
+        char c = *parser.p++;
+        if (c == '"') return true;
+        if (c != '\\') return JsonFail(parser, "Control character in string");
+        if (parser.p == parser.end) break;
+
+        c = *parser.p++;
+        switch (c)
+        {
+        case '"': out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '/': out += '/'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u':
+        {
+            uint32_t codePoint;
+            if (!ParseHex4(parser, &codePoint)) return false;
+            // Characters outside the basic plane come as a surrogate pair
+            if (codePoint >= 0xD800 && codePoint < 0xDC00 && parser.end - parser.p >= 2 && parser.p[0] == '\\' && parser.p[1] == 'u')
+            {
+                const char* low = parser.p;
+                parser.p += 2;
+                uint32_t lowSurrogate;
+                if (!ParseHex4(parser, &lowSurrogate)) return false;
+                if (lowSurrogate >= 0xDC00 && lowSurrogate < 0xE000)
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+                else
+                    parser.p = low;
+            }
+            AppendUtf8(out, codePoint);
+            break;
+        }
+        default:
+            return JsonFail(parser, "Bad escape in string");
+        }
+    }
+    return JsonFail(parser, "Unterminated string");
+}
+
+static bool ParseNumber(JsonParser& parser, double* value)
+{
+    const char* start = parser.p;
+    if (parser.p < parser.end && *parser.p == '-') ++parser.p;
+    while (parser.p < parser.end && (unsigned char)(*parser.p - '0') < 10) ++parser.p;
+    if (parser.p < parser.end && *parser.p == '.')
+        for (++parser.p; parser.p < parser.end && (unsigned char)(*parser.p - '0') < 10; ++parser.p) {}
+    if (parser.p < parser.end && (*parser.p == 'e' || *parser.p == 'E'))
+    {
+        ++parser.p;
+        if (parser.p < parser.end && (*parser.p == '-' || *parser.p == '+')) ++parser.p;
+        while (parser.p < parser.end && (unsigned char)(*parser.p - '0') < 10) ++parser.p;
+    }
+
+    // The text is not null terminated, so strtod gets a copy; numbers in metadata are short
+    char buffer[64];
+    size_t length = (size_t)(parser.p - start);
+    if (length == 0 || length >= sizeof(buffer)) return JsonFail(parser, "Bad number");
+    memcpy(buffer, start, length);
+    buffer[length] = 0;
+    char* parsedEnd;
+    *value = strtod(buffer, &parsedEnd);
+    if (parsedEnd != buffer + length) return JsonFail(parser, "Bad number");
+    return true;
+}
+
+static bool ParseValue(JsonParser& parser, JsonValue& value, int depth)
+{
+    if (depth > MAX_DEPTH) return JsonFail(parser, "Nesting too deep");
+    SkipWhitespace(parser);
+    if (parser.p == parser.end) return JsonFail(parser, "Unexpected end of text");
+
+    switch (*parser.p)
+    {
+    case '{':
+        value.type = JsonType::Object;
+        ++parser.p;
+        SkipWhitespace(parser);
+        if (parser.p < parser.end && *parser.p == '}') { ++parser.p; return true; }
+        for (;;)
+        {
+            SkipWhitespace(parser);
+            if (parser.p == parser.end || *parser.p != '"') return JsonFail(parser, "Expected a member name");
+            value.keys.emplace_back();
+            if (!ParseString(parser, value.keys.back())) return false;
+            SkipWhitespace(parser);
+            if (!Expect(parser, ":")) return false;
+            value.elements.emplace_back();
+            if (!ParseValue(parser, value.elements.back(), depth + 1)) return false;
+            SkipWhitespace(parser);
+            if (parser.p < parser.end && *parser.p == ',') { ++parser.p; continue; }
+            return Expect(parser, "}");
+        }
+    case '[':
+        value.type = JsonType::Array;
+        ++parser.p;
+        SkipWhitespace(parser);
+        if (parser.p < parser.end && *parser.p == ']') { ++parser.p; return true; }
+        for (;;)
+        {
+            value.elements.emplace_back();
+            if (!ParseValue(parser, value.elements.back(), depth + 1)) return false;
+            SkipWhitespace(parser);
+            if (parser.p < parser.end && *parser.p == ',') { ++parser.p; continue; }
+            return Expect(parser, "]");
+        }
+    case '"':
+        value.type = JsonType::String;
+        return ParseString(parser, value.string);
+    case 't':
+        value.type = JsonType::Bool;
+        value.boolean = true;
+        return Expect(parser, "true");
+    case 'f':
+        value.type = JsonType::Bool;
+        return Expect(parser, "false");
+    case 'n':
+        return Expect(parser, "null");
+    default:
+        value.type = JsonType::Number;
+        return ParseNumber(parser, &value.number);
+    }
+}
+
+bool ParseJson(const char* text, size_t size, JsonValue& root, std::string& error)
+{
+    JsonParser parser = { text, text + size, text, &error };
+    error.clear();
+    root = JsonValue();
+    // Skip a UTF-8 byte order mark
+    if (size >= 3 && memcmp(text, "\xEF\xBB\xBF", 3) == 0) parser.p += 3;
+    if (!ParseValue(parser, root, 0)) return false;
+    SkipWhitespace(parser);
+    // A GLB JSON chunk is padded with spaces, and some writers pad with nulls
+    while (parser.p < parser.end && *parser.p == 0) ++parser.p;
+    if (parser.p != parser.end) return JsonFail(parser, "Trailing characters");
+    return true;
+}
+
+const JsonValue* JsonMember(const JsonValue* value, const char* key)
+{
+    if (value == nullptr || value->type != JsonType::Object) return nullptr;
+    for (size_t i = 0; i < value->keys.size(); ++i)
+        if (value->keys[i] == key)
+            return &value->elements[i];
+    return nullptr;
+}
+
+const JsonValue* JsonElement(const JsonValue* value, size_t index)
+{
+    if (value == nullptr || value->type != JsonType::Array || index >= value->elements.size()) return nullptr;
+    return &value->elements[index];
+}
+
+size_t JsonSize(const JsonValue* value)
+{
+    if (value == nullptr || (value->type != JsonType::Array && value->type != JsonType::Object)) return 0;
+    return value->elements.size();
+}
+
+double JsonNumber(const JsonValue* value, double fallback)
+{
+    return value != nullptr && value->type == JsonType::Number ? value->number : fallback;
+}
+
+int64_t JsonInt(const JsonValue* value, int64_t fallback)
+{
+    // Anything that cannot be an exact integer is treated as missing
+    if (value == nullptr || value->type != JsonType::Number) return fallback;
+    if (value->number < -9.0e15 || value->number > 9.0e15 || (double)(int64_t)value->number != value->number) return fallback;
+    return (int64_t)value->number;
+}
+
+bool JsonBool(const JsonValue* value, bool fallback)
+{
+    return value != nullptr && value->type == JsonType::Bool ? value->boolean : fallback;
+}
+
+const char* JsonString(const JsonValue* value, const char* fallback)
+{
+    return value != nullptr && value->type == JsonType::String ? value->string.c_str() : fallback;
+}
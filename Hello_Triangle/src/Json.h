@@ -0,0 +1,49 @@
+#ifndef __Json_h__
+#define __Json_h__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// A small JSON reader for asset metadata such as glTF
+// The whole document is parsed into a tree up front; the accessors below take nullptr for a missing
+// value and fall back to a default, so optional members can be read without checking every step.
+
+enum class JsonType : uint8_t
+{
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object
+};
+
+struct JsonValue
+{
+    JsonType type = JsonType::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;             // UTF-8, escapes already resolved
+    std::vector<JsonValue> elements; // array elements, or object member values
+    std::vector<std::string> keys;  // object member names, in step with elements
+};
+
+// Parse size bytes of JSON text, which need not be null terminated
+// Returns false and describes the problem in error if the text is not valid JSON
+bool ParseJson(const char* text, size_t size, JsonValue& root, std::string& error);
+
+// A member of an object, or nullptr if value is not an object or has no such member
+const JsonValue* JsonMember(const JsonValue* value, const char* key);
+// An element of an array, or nullptr if value is not an array or is too short
+const JsonValue* JsonElement(const JsonValue* value, size_t index);
+// Elements of an array or members of an object; 0 for anything else
+size_t JsonSize(const JsonValue* value);
+
+double JsonNumber(const JsonValue* value, double fallback);
+int64_t JsonInt(const JsonValue* value, int64_t fallback);
+bool JsonBool(const JsonValue* value, bool fallback);
+const char* JsonString(const JsonValue* value, const char* fallback);
+
+#endif
@@ -0,0 +1,60 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "MappedFile.h"
+
+const unsigned char* MapFile(const char* filePath, size_t* size, bool sequential)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+    LARGE_INTEGER fileSize;
+    const void* view = nullptr;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL)
+        {
+            view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping); // the view keeps the mapping alive
+        }
+        *size = (size_t)fileSize.QuadPart;
+    }
+    CloseHandle(file);
+    return (const unsigned char*)view;
+#else
+    int fd = open(filePath, O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat fileStat;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+    {
+        view = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        *size = (size_t)fileStat.st_size;
+        if (view != MAP_FAILED && sequential)
+        {
+            // Advice values are not flags; read ahead in large chunks, and start reading now
+            madvise(view, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+            madvise(view, (size_t)fileStat.st_size, MADV_WILLNEED);
+        }
+    }
+    close(fd); // the mapping keeps the file alive
+    return view == MAP_FAILED ? nullptr : (const unsigned char*)view;
+#endif
+}
+
+void UnmapFile(const unsigned char* data, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap((void*)data, size);
+#endif
+}
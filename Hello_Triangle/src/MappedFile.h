@@ -0,0 +1,11 @@
+#ifndef __MappedFile_h__
+#define __MappedFile_h__
+#include <stddef.h>
+
+// Map a whole file read-only into memory; returns nullptr if it is missing or empty
+// sequential tells the OS the file will be read front to back once, so it reads ahead aggressively
+// instead of faulting pages in one at a time
+const unsigned char* MapFile(const char* filePath, size_t* size, bool sequential = false);
+void UnmapFile(const unsigned char* data, size_t size);
+
+#endif
@@ -0,0 +1,106 @@
+#include <ctype.h>
+#include <string.h>
+#include <string>
+#include "Data.h"
+#include "ErrorHandling.h"
+#include "MappedFile.h"
+#include "Mesh.h"
+
+// Check everything the loader relies on before touching any of it
+static bool ValidateMesh(const unsigned char* data, size_t size)
+{
+    const MeshHeader* header = (const MeshHeader*)data;
+    if (size < sizeof(MeshHeader) || memcmp(header->magic, MESH_MAGIC, 4) != 0 || header->version != MESH_VERSION)
+        return false;
+    uint64_t tableSize = (uint64_t)header->streamCount * sizeof(MeshStream) + (uint64_t)header->drawCount * sizeof(MeshDraw);
+    if (tableSize > size - sizeof(MeshHeader))
+        return false;
+
+    const MeshStream* streams = (const MeshStream*)(data + sizeof(MeshHeader));
+    for (uint32_t i = 0; i < header->streamCount; ++i)
+    {
+        const MeshStream& stream = streams[i];
+        if (stream.offset > size || stream.size > size - stream.offset || stream.size == 0 || stream.stride == 0)
+            return false;
+        if (stream.kind == MESH_STREAM_INDEX && stream.stride != 1 && stream.stride != 2 && stream.stride != 4)
+            return false;
+        if (stream.kind != MESH_STREAM_INDEX && stream.kind != MESH_STREAM_VERTEX)
+            return false;
+    }
+
+    const MeshDraw* draws = (const MeshDraw*)(streams + header->streamCount);
+    for (uint32_t i = 0; i < header->drawCount; ++i)
+    {
+        const MeshDraw& draw = draws[i];
+        if (draw.vertexStream >= header->streamCount || streams[draw.vertexStream].kind != MESH_STREAM_VERTEX
+            || draw.indexStream >= header->streamCount || streams[draw.indexStream].kind != MESH_STREAM_INDEX)
+            return false;
+        const MeshStream& indices = streams[draw.indexStream];
+        if ((uint64_t)draw.firstIndex + draw.indexCount > indices.size / indices.stride)
+            return false;
+    }
+    return true;
+}
+
+static void UploadMesh(const unsigned char* data, Mesh& mesh)
+{
+    const MeshHeader* header = (const MeshHeader*)data;
+    const MeshStream* streams = (const MeshStream*)(data + sizeof(MeshHeader));
+    const MeshDraw* draws = (const MeshDraw*)(streams + header->streamCount);
+
+    err_checkGL("Before loading mesh");
+    mesh.streams.clear();
+    mesh.streams.resize(header->streamCount);
+    for (uint32_t i = 0; i < header->streamCount; ++i)
+    {
+        MeshStreamBuffer& stream = mesh.streams[i];
+        stream.buffer = CreateBuffer();
+        stream.layoutHash = streams[i].layoutHash;
+        stream.kind = streams[i].kind;
+        stream.stride = (GLsizei)streams[i].stride;
+        stream.size = (GLsizeiptr)streams[i].size;
+        // The driver reads straight out of the mapping; pages are faulted in as it goes
+        glNamedBufferStorage(stream.buffer.get(), stream.size, data + streams[i].offset, 0);
+    }
+    mesh.draws.assign(draws, draws + header->drawCount);
+    err_checkGL("Loading mesh");
+}
+
+bool LoadMesh(const char* filePath, Mesh& mesh)
+{
+    // Packed meshes are already mapped in with the archive
+    const void* packedData;
+    size_t packedSize;
+    if (findPackedFile(filePath, &packedData, &packedSize))
+    {
+        if (!ValidateMesh((const unsigned char*)packedData, packedSize)) return false;
+        UploadMesh((const unsigned char*)packedData, mesh);
+        return true;
+    }
+
+    size_t size = 0;
+    const unsigned char* data = MapFile(filePath, &size, true);
+    if (data == nullptr)
+        data = MapFile(DataPathToFilePath(filePath).c_str(), &size, true);
+    if (data == nullptr) return false;
+
+    bool valid = ValidateMesh(data, size);
+    if (valid)
+        UploadMesh(data, mesh);
+    UnmapFile(data, size);
+    return valid;
+}
+
+GLenum MeshIndexType(const MeshStreamBuffer& stream)
+{
+    return stream.stride == 1 ? GL_UNSIGNED_BYTE : stream.stride == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+bool IsMeshPath(const char* filePath)
+{
+    const char* extension = strrchr(filePath, '.');
+    if (extension == nullptr) return false;
+    std::string lower(extension);
+    for (char& c : lower) c = (char)tolower((unsigned char)c);
+    return lower == ".mesh";
+}
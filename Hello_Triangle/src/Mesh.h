@@ -0,0 +1,58 @@
+#ifndef __Mesh_h__
+#define __Mesh_h__
+
+#include <stdint.h>
+#include <vector>
+#include <GL/glew.h>
+#include "GLObjects.h"
+#include "MeshFormat.h"
+#include "VertexArrayCache.h"
+
+// A binary mesh (see MeshFormat.h) living in GL buffers, one buffer per stream
+struct MeshStreamBuffer
+{
+    Buffer buffer;
+    uint64_t layoutHash; // compare with VertexLayout::hash before drawing with a layout
+    uint32_t kind;       // MESH_STREAM_VERTEX or MESH_STREAM_INDEX
+    GLsizei stride;
+    GLsizeiptr size;
+};
+
+struct Mesh
+{
+    std::vector<MeshStreamBuffer> streams;
+    std::vector<MeshDraw> draws;
+};
+
+// Load a binary mesh, found the same way as loadFile: packed assets first, then the path as given,
+// then the data directory. The file is mapped and each stream goes from the mapping straight into
+// glNamedBufferStorage, so loading costs the read and the upload and nothing else.
+// Returns false if the file is missing or not a valid mesh.
+bool LoadMesh(const char* filePath, Mesh& mesh);
+
+// The GL index type of an index stream
+GLenum MeshIndexType(const MeshStreamBuffer& stream);
+
+// Whether a path names a binary mesh, by its extension
+bool IsMeshPath(const char* filePath);
+
+// Draw every draw of the mesh whose vertices are in Layout, with whatever program is current.
+// Draws of other layouts are skipped; returns how many were drawn
+template <typename Layout>
+size_t DrawMesh(const Mesh& mesh)
+{
+    size_t drawn = 0;
+    for (const MeshDraw& draw : mesh.draws)
+    {
+        const MeshStreamBuffer& vertices = mesh.streams[draw.vertexStream];
+        const MeshStreamBuffer& indices = mesh.streams[draw.indexStream];
+        if (vertices.layoutHash != Layout::hash) continue;
+        BindVertexLayout<Layout>(vertices.buffer.get(), 0, indices.buffer.get());
+        glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)draw.indexCount, MeshIndexType(indices),
+            (const void*)((uintptr_t)draw.firstIndex * indices.stride), draw.baseVertex);
+        ++drawn;
+    }
+    return drawn;
+}
+
+#endif
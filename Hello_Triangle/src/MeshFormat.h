@@ -0,0 +1,48 @@
+#ifndef __MeshFormat_h__
+#define __MeshFormat_h__
+#include <stdint.h>
+#include <stddef.h>
+
+// On-disk layout of a binary mesh, shared by the runtime loader and the offline tools that write it.
+//
+//   MeshHeader
+//   MeshStream[streamCount]
+//   MeshDraw[drawCount]
+//   stream data                each stream starts on a MESH_ALIGNMENT boundary
+//
+// Stream data is exactly what goes into the GL buffer, so loading is a mapping and an upload with
+// nothing parsed or copied in between. All integers are little-endian.
+
+#define MESH_MAGIC "MSH1"
+#define MESH_VERSION 1
+#define MESH_ALIGNMENT 64
+
+#define MESH_STREAM_VERTEX 0
+#define MESH_STREAM_INDEX 1
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t streamCount;
+    uint32_t drawCount;
+} MeshHeader;
+
+typedef struct {
+    uint64_t offset;     // from the start of the file
+    uint64_t size;       // in bytes
+    uint64_t layoutHash; // VertexLayout::hash of the vertices; 0 for index streams
+    uint32_t kind;       // MESH_STREAM_VERTEX or MESH_STREAM_INDEX
+    uint32_t stride;     // bytes per vertex, or per index (1, 2 or 4)
+} MeshStream;
+
+// A range of one index stream drawn from one vertex stream; maps straight onto a DrawElementsIndirectCommand
+typedef struct {
+    uint32_t vertexStream;
+    uint32_t indexStream;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t baseVertex;
+    uint32_t padding;
+} MeshDraw;
+
+#endif
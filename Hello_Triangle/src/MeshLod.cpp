@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include "MeshLod.h"
+
+// How much more a border's own plane counts than the triangles beside it, so borders keep their shape
+const float LOD_BORDER_WEIGHT = 10.0f;
+// The furthest a level may stray from the full detail mesh, as a fraction of the mesh's radius
+const float LOD_MAX_ERROR = 0.1f;
+
+enum class VertexKind
+{
+    Manifold, // free to collapse onto any neighbour
+    Border,   // on an open border; only collapses along it
+    Locked    // on a seam, or where borders meet
+};
+
+// Weighted sum of squared distances to planes: for a plane (a, b, c, d), p -> (a x + b y + c z + d)^2
+struct Quadric
+{
+    double a2, b2, c2, d2, ab, ac, ad, bc, bd, cd;
+    double weight;
+};
+
+struct Collapse
+{
+    uint32_t from;
+    uint32_t to;
+    float error;
+
+    bool operator<(const Collapse& other) const { return error < other.error; }
+};
+
+static glm::vec3 Position(const float* positions, size_t positionStride, uint32_t vertex)
+{
+    const float* p = (const float*)((const char*)positions + vertex * positionStride);
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+static void AddPlane(Quadric& q, const glm::vec3& normal, float distance, double weight)
+{
+    double a = normal.x, b = normal.y, c = normal.z, d = distance;
+    q.a2 += a * a * weight;
+    q.b2 += b * b * weight;
+    q.c2 += c * c * weight;
+    q.d2 += d * d * weight;
+    q.ab += a * b * weight;
+    q.ac += a * c * weight;
+    q.ad += a * d * weight;
+    q.bc += b * c * weight;
+    q.bd += b * d * weight;
+    q.cd += c * d * weight;
+    q.weight += weight;
+}
+
+static void AddQuadric(Quadric& q, const Quadric& other)
+{
+    q.a2 += other.a2;
+    q.b2 += other.b2;
+    q.c2 += other.c2;
+    q.d2 += other.d2;
+    q.ab += other.ab;
+    q.ac += other.ac;
+    q.ad += other.ad;
+    q.bc += other.bc;
+    q.bd += other.bd;
+    q.cd += other.cd;
+    q.weight += other.weight;
+}
+
+// Root mean square distance from p to the planes of q and other together
+static float CollapseError(const Quadric& q, const Quadric& other, const glm::vec3& p)
+{
+    Quadric sum = q;
+    AddQuadric(sum, other);
+    double x = p.x, y = p.y, z = p.z;
+    double squared = sum.a2 * x * x + sum.b2 * y * y + sum.c2 * z * z + sum.d2 +
+        2.0 * (sum.ab * x * y + sum.ac * x * z + sum.bc * y * z + sum.ad * x + sum.bd * y + sum.cd * z);
+    return sum.weight > 0.0 && squared > 0.0 ? (float)sqrt(squared / sum.weight) : 0.0f;
+}
+
+static uint64_t EdgeKey(uint32_t from, uint32_t to)
+{
+    return (uint64_t)from << 32 | to;
+}
+
+// Sorted directed edges of a triangle list, with each vertex replaced by the first at its position
+static void CollectEdges(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& samePosition, std::vector<uint64_t>& edges)
+{
+    edges.resize(indices.size());
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+        for (int k = 0; k < 3; ++k)
+            edges[t + k] = EdgeKey(samePosition[indices[t + k]], samePosition[indices[t + (k + 1) % 3]]);
+    std::sort(edges.begin(), edges.end());
+}
+
+// An edge only one triangle has, going one way or the other
+static bool IsBorderEdge(const std::vector<uint64_t>& edges, uint32_t a, uint32_t b)
+{
+    bool forward = std::binary_search(edges.begin(), edges.end(), EdgeKey(a, b));
+    bool backward = std::binary_search(edges.begin(), edges.end(), EdgeKey(b, a));
+    return forward != backward;
+}
+
+// Whether moving from onto to turns any triangle around from over, or very nearly
+static bool CollapseFlips(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& firstTriangle, const std::vector<uint32_t>& vertexTriangles,
+    const float* positions, size_t positionStride, uint32_t from, uint32_t to)
+{
+    glm::vec3 source = Position(positions, positionStride, from), target = Position(positions, positionStride, to);
+    for (uint32_t i = firstTriangle[from]; i < firstTriangle[from + 1]; ++i)
+    {
+        const uint32_t* v = &indices[vertexTriangles[i] * 3];
+        if (v[0] == to || v[1] == to || v[2] == to) continue; // this one disappears
+        int k = v[0] == from ? 0 : v[1] == from ? 1 : 2;
+        glm::vec3 b = Position(positions, positionStride, v[(k + 1) % 3]), c = Position(positions, positionStride, v[(k + 2) % 3]);
+        glm::vec3 before = glm::cross(b - source, c - source), after = glm::cross(b - target, c - target);
+        if (glm::dot(before, after) < 0.25f * glm::length(before) * glm::length(after))
+            return true;
+    }
+    return false;
+}
+
+size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+    size_t positionStride, size_t targetIndexCount, float targetError, float* error)
+{
+    std::vector<uint32_t> current;
+    current.reserve(indexCount);
+    for (size_t t = 0; t + 2 < indexCount; t += 3)
+        if (indices[t] != indices[t + 1] && indices[t + 1] != indices[t + 2] && indices[t + 2] != indices[t])
+            current.insert(current.end(), indices + t, indices + t + 3);
+
+    // Vertices sharing a position are the two sides of a seam; edges are compared by position so that
+    // seams are not mistaken for borders
+    std::vector<uint32_t> samePosition(vertexCount), byPosition(vertexCount), positionCount(vertexCount, 0);
+    for (size_t v = 0; v < vertexCount; ++v) byPosition[v] = (uint32_t)v;
+    std::sort(byPosition.begin(), byPosition.end(), [&](uint32_t a, uint32_t b) {
+        glm::vec3 pa = Position(positions, positionStride, a), pb = Position(positions, positionStride, b);
+        return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+    });
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        uint32_t v = byPosition[i];
+        bool same = i > 0 && glm::dot(Position(positions, positionStride, v) - Position(positions, positionStride, byPosition[i - 1]),
+            Position(positions, positionStride, v) - Position(positions, positionStride, byPosition[i - 1])) == 0.0f;
+        samePosition[v] = same ? samePosition[byPosition[i - 1]] : v;
+        ++positionCount[samePosition[v]];
+    }
+
+    std::vector<uint64_t> edges;
+    CollectEdges(current, samePosition, edges);
+    std::vector<uint8_t> bordersOut(vertexCount, 0), bordersIn(vertexCount, 0);
+    for (size_t t = 0; t < current.size(); t += 3)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            uint32_t a = samePosition[current[t + k]], b = samePosition[current[t + (k + 1) % 3]];
+            if (!std::binary_search(edges.begin(), edges.end(), EdgeKey(b, a)))
+            {
+                bordersOut[a] = (uint8_t)std::min(bordersOut[a] + 1, 2);
+                bordersIn[b] = (uint8_t)std::min(bordersIn[b] + 1, 2);
+            }
+        }
+    }
+    std::vector<VertexKind> kinds(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        uint32_t p = samePosition[v];
+        if (positionCount[p] > 1)
+            kinds[v] = VertexKind::Locked;
+        else if (bordersOut[p] == 0 && bordersIn[p] == 0)
+            kinds[v] = VertexKind::Manifold;
+        else if (bordersOut[p] == 1 && bordersIn[p] == 1)
+            kinds[v] = VertexKind::Border;
+        else
+            kinds[v] = VertexKind::Locked;
+    }
+
+    // Each vertex starts with the planes of the triangles around it, weighted by area, and of any border
+    // edges it is on, standing upright along them
+    std::vector<Quadric> quadrics(vertexCount, Quadric());
+    for (size_t t = 0; t < current.size(); t += 3)
+    {
+        glm::vec3 p[3];
+        for (int k = 0; k < 3; ++k) p[k] = Position(positions, positionStride, current[t + k]);
+        glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+        float length = glm::length(normal);
+        if (length < 1e-20f) continue;
+        normal = normal * (1.0f / length);
+        for (int k = 0; k < 3; ++k)
+            AddPlane(quadrics[current[t + k]], normal, -glm::dot(normal, p[0]), length * 0.5f);
+
+        for (int k = 0; k < 3; ++k)
+        {
+            uint32_t a = current[t + k], b = current[t + (k + 1) % 3];
+            if (std::binary_search(edges.begin(), edges.end(), EdgeKey(samePosition[b], samePosition[a]))) continue;
+            glm::vec3 edge = p[(k + 1) % 3] - p[k];
+            glm::vec3 upright = glm::cross(edge, normal);
+            float uprightLength = glm::length(upright);
+            if (uprightLength < 1e-20f) continue;
+            upright = upright * (1.0f / uprightLength);
+            double weight = glm::dot(edge, edge) * LOD_BORDER_WEIGHT;
+            AddPlane(quadrics[a], upright, -glm::dot(upright, p[k]), weight);
+            AddPlane(quadrics[b], upright, -glm::dot(upright, p[k]), weight);
+        }
+    }
+
+    // Collapse in passes: find every edge's cheapest collapse, then make the cheapest of them, touching
+    // each neighbourhood at most once per pass so every check sees the triangles as they are
+    std::vector<uint32_t> firstTriangle(vertexCount + 1), vertexTriangles, remap(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) remap[v] = (uint32_t)v;
+    std::vector<Collapse> collapses;
+    std::vector<bool> touched(vertexCount);
+    float worstError = 0.0f;
+    while (current.size() > targetIndexCount)
+    {
+        std::fill(firstTriangle.begin(), firstTriangle.end(), 0);
+        for (uint32_t v : current) ++firstTriangle[v + 1];
+        for (size_t v = 0; v < vertexCount; ++v) firstTriangle[v + 1] += firstTriangle[v];
+        vertexTriangles.resize(current.size());
+        {
+            std::vector<uint32_t> cursor(firstTriangle.begin(), firstTriangle.end() - 1);
+            for (size_t i = 0; i < current.size(); ++i)
+                vertexTriangles[cursor[current[i]]++] = (uint32_t)(i / 3);
+        }
+        CollectEdges(current, samePosition, edges);
+
+        collapses.clear();
+        for (size_t t = 0; t < current.size(); t += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                uint32_t a = current[t + k], b = current[t + (k + 1) % 3];
+                Collapse best = { 0, 0, FLT_MAX };
+                for (int direction = 0; direction < 2; ++direction)
+                {
+                    uint32_t from = direction == 0 ? a : b, to = direction == 0 ? b : a;
+                    if (kinds[from] == VertexKind::Locked) continue;
+                    if (kinds[from] == VertexKind::Border && !IsBorderEdge(edges, samePosition[from], samePosition[to])) continue;
+                    float cost = CollapseError(quadrics[from], quadrics[to], Position(positions, positionStride, to));
+                    if (cost < best.error)
+                    {
+                        best.from = from;
+                        best.to = to;
+                        best.error = cost;
+                    }
+                }
+                if (best.error <= targetError) collapses.push_back(best);
+            }
+        }
+        std::sort(collapses.begin(), collapses.end());
+
+        std::fill(touched.begin(), touched.end(), false);
+        size_t triangleCount = current.size() / 3, targetTriangles = targetIndexCount / 3;
+        size_t applied = 0;
+        for (const Collapse& collapse : collapses)
+        {
+            if (triangleCount <= targetTriangles) break;
+            if (touched[collapse.from] || touched[collapse.to]) continue;
+            if (CollapseFlips(current, firstTriangle, vertexTriangles, positions, positionStride, collapse.from, collapse.to)) continue;
+
+            for (uint32_t i = firstTriangle[collapse.from]; i < firstTriangle[collapse.from + 1]; ++i)
+            {
+                const uint32_t* v = &current[vertexTriangles[i] * 3];
+                if (v[0] == collapse.to || v[1] == collapse.to || v[2] == collapse.to) --triangleCount;
+                touched[v[0]] = touched[v[1]] = touched[v[2]] = true;
+            }
+            touched[collapse.to] = true;
+            remap[collapse.from] = collapse.to;
+            AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+            worstError = std::max(worstError, collapse.error);
+            ++applied;
+        }
+        if (applied == 0) break;
+
+        size_t kept = 0;
+        for (size_t t = 0; t < current.size(); t += 3)
+        {
+            uint32_t a = remap[current[t]], b = remap[current[t + 1]], c = remap[current[t + 2]];
+            if (a == b || b == c || c == a) continue;
+            current[kept++] = a;
+            current[kept++] = b;
+            current[kept++] = c;
+        }
+        current.resize(kept);
+        for (size_t v = 0; v < vertexCount; ++v) remap[v] = (uint32_t)v;
+    }
+
+    std::copy(current.begin(), current.end(), destination);
+    if (error != nullptr) *error = worstError;
+    return current.size();
+}
+
+void BuildMeshLods(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+    MeshLodChain& chain, unsigned maxLevels)
+{
+    glm::vec3 low(FLT_MAX), high(-FLT_MAX);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        glm::vec3 p = Position(positions, positionStride, (uint32_t)v);
+        for (int c = 0; c < 3; ++c)
+        {
+            low[c] = std::min(low[c], p[c]);
+            high[c] = std::max(high[c], p[c]);
+        }
+    }
+    glm::vec3 centre = vertexCount > 0 ? (low + high) * 0.5f : glm::vec3(0.0f);
+    float radius = 0.0f;
+    for (size_t v = 0; v < vertexCount; ++v)
+        radius = std::max(radius, glm::length(Position(positions, positionStride, (uint32_t)v) - centre));
+    chain.sphere = glm::vec4(centre.x, centre.y, centre.z, radius);
+
+    IndexRange full = { 0, (GLuint)indexCount };
+    chain.indices.assign(indices, indices + indexCount);
+    chain.levels.assign(1, full);
+    chain.errors.assign(1, 0.0f);
+
+    // Each level is simplified from the last, so the errors add up
+    std::vector<uint32_t> level(indices, indices + indexCount);
+    while (chain.levels.size() < maxLevels)
+    {
+        float budget = radius * LOD_MAX_ERROR - chain.errors.back();
+        if (budget <= 0.0f) break;
+        float error;
+        size_t count = SimplifyMesh(level.data(), level.data(), level.size(), positions, vertexCount, positionStride, level.size() / 6 * 3, budget, &error);
+        // Stop once a level would be empty or barely smaller than the last
+        if (count == 0 || count * 10 > level.size() * 9) break;
+        level.resize(count);
+
+        IndexRange range = { (GLuint)chain.indices.size(), (GLuint)count };
+        chain.indices.insert(chain.indices.end(), level.begin(), level.end());
+        chain.levels.push_back(range);
+        chain.errors.push_back(chain.errors.back() + error);
+    }
+}
+
+float LodProjectionScale(float fovY, float viewportHeight)
+{
+    return viewportHeight / (2.0f * tanf(fovY * 0.5f));
+}
+
+size_t SelectMeshLod(const MeshLodChain& chain, const glm::vec3& cameraPosition, float projectionScale, float maxPixelError)
+{
+    // Measured to the nearest point of the bounds; from inside them, only full detail will do
+    glm::vec3 offset = cameraPosition - glm::vec3(chain.sphere.x, chain.sphere.y, chain.sphere.z);
+    float distance = glm::length(offset) - chain.sphere.w;
+    if (distance <= 0.0f) return 0;
+
+    size_t level = 0;
+    while (level + 1 < chain.levels.size() && chain.errors[level + 1] * projectionScale <= maxPixelError * distance)
+        ++level;
+    return level;
+}
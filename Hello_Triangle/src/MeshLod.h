@@ -0,0 +1,44 @@
+#ifndef __MeshLod_h__
+#define __MeshLod_h__
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+#include "IndexBuffer.h"
+
+// Levels of detail: simplified copies of a mesh's triangles over the same vertices, so every level lives in
+// one element buffer and switching level only changes a draw command's firstIndex and count.
+// Simplification collapses edges in order of quadric error (Garland and Heckbert); vertices only ever move
+// onto one of their neighbours, so no new vertices are needed. Vertices on uv or normal seams stay where
+// they are so the seams don't tear, and open borders only collapse along themselves.
+
+// Most levels kept per mesh, the full detail one included
+#define MESH_LOD_MAX_LEVELS 8
+
+// Simplify an indexed triangle list into destination, which may be indices, collapsing edges until at most
+// targetIndexCount indices are left or the next collapse would move the surface further than targetError
+// (in the units of positions). positions points at the first vertex's x, y, z floats, positionStride bytes
+// apart. Returns the number of indices written; error, if given, receives how far the surface moved
+size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+    size_t positionStride, size_t targetIndexCount, float targetError, float* error = nullptr);
+
+struct MeshLodChain
+{
+    std::vector<uint32_t> indices;   // every level's triangle list, full detail first
+    std::vector<IndexRange> levels;  // where each level is in indices
+    std::vector<float> errors;       // how far each level's surface is from the full detail one, in model units
+    glm::vec4 sphere;                // bounds of the mesh: centre, radius
+};
+
+// Build levels of roughly half the triangles of the one before, until simplifying stops paying
+void BuildMeshLods(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride,
+    MeshLodChain& chain, unsigned maxLevels = MESH_LOD_MAX_LEVELS);
+
+// Pixels covered by one unit at a distance of one unit, for a projection with a vertical field of view
+// of fovY radians onto a viewport viewportHeight pixels high
+float LodProjectionScale(float fovY, float viewportHeight);
+
+// The coarsest level whose error covers at most maxPixelError pixels, seen from cameraPosition in model space
+size_t SelectMeshLod(const MeshLodChain& chain, const glm::vec3& cameraPosition, float projectionScale, float maxPixelError = 1.0f);
+
+#endif
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include "DrawCommands.h"
+#include "ErrorHandling.h"
+#include "Meshlets.h"
+#include "ShaderLoader.h"
+
+static glm::vec3 Position(const float* positions, size_t positionStride, uint32_t vertex)
+{
+    const float* p = (const float*)((const char*)positions + vertex * positionStride);
+    return glm::vec3(p[0], p[1], p[2]);
+}
+
+// Bounds and normal cone of the triangles mesh.indices[firstIndex, firstIndex + indexCount)
+static Meshlet MeshletBounds(const MeshletMesh& mesh, GLuint firstIndex, GLuint indexCount, GLuint vertexCount,
+    const float* positions, size_t positionStride)
+{
+    Meshlet meshlet;
+    meshlet.firstIndex = firstIndex;
+    meshlet.indexCount = indexCount;
+    meshlet.vertexCount = vertexCount;
+    meshlet.padding = 0;
+
+    // Sphere around the centre of the bounding box
+    const uint32_t* indices = &mesh.indices[firstIndex];
+    glm::vec3 low(FLT_MAX), high(-FLT_MAX);
+    for (GLuint i = 0; i < indexCount; ++i)
+    {
+        glm::vec3 p = Position(positions, positionStride, indices[i]);
+        for (int c = 0; c < 3; ++c)
+        {
+            low[c] = std::min(low[c], p[c]);
+            high[c] = std::max(high[c], p[c]);
+        }
+    }
+    glm::vec3 centre = (low + high) * 0.5f;
+    float radius = 0.0f;
+    for (GLuint i = 0; i < indexCount; ++i)
+        radius = std::max(radius, glm::length(Position(positions, positionStride, indices[i]) - centre));
+    meshlet.sphere = glm::vec4(centre.x, centre.y, centre.z, radius);
+
+    // The cone's axis is the average face normal; its cutoff is how far the furthest normal strays
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec3> corners;
+    glm::vec3 axis(0.0f);
+    for (GLuint i = 0; i + 2 < indexCount; i += 3)
+    {
+        glm::vec3 a = Position(positions, positionStride, indices[i]);
+        glm::vec3 b = Position(positions, positionStride, indices[i + 1]);
+        glm::vec3 c = Position(positions, positionStride, indices[i + 2]);
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float area = glm::length(normal);
+        if (area < 1e-20f) continue;
+        normals.push_back(normal * (1.0f / area));
+        corners.push_back(a);
+        axis += normals.back();
+    }
+    float axisLength = glm::length(axis);
+    float minimumDot = 1.0f;
+    if (axisLength > 1e-20f)
+    {
+        axis = axis * (1.0f / axisLength);
+        for (const glm::vec3& normal : normals)
+            minimumDot = std::min(minimumDot, glm::dot(axis, normal));
+    }
+
+    if (normals.empty() || axisLength <= 1e-20f || minimumDot <= 0.0f)
+    {
+        // Some triangle faces every camera position, so the cone can never cull
+        meshlet.coneApex = glm::vec4(centre.x, centre.y, centre.z, 0.0f);
+        meshlet.cone = glm::vec4(0.0f, 0.0f, 1.0f, 2.0f);
+        return meshlet;
+    }
+
+    // Move the apex back along the axis until it is behind every triangle's plane; from there, a camera
+    // looking along the axis to within the cone's angle sees only the backs of the triangles
+    float distance = 0.0f;
+    for (size_t t = 0; t < normals.size(); ++t)
+        distance = std::max(distance, glm::dot(centre - corners[t], normals[t]) / glm::dot(axis, normals[t]));
+    glm::vec3 apex = centre - axis * distance;
+    meshlet.coneApex = glm::vec4(apex.x, apex.y, apex.z, 0.0f);
+    meshlet.cone = glm::vec4(axis.x, axis.y, axis.z, sqrtf(1.0f - minimumDot * minimumDot));
+    return meshlet;
+}
+
+void BuildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, MeshletMesh& mesh)
+{
+    size_t triangleCount = indexCount / 3;
+    mesh.meshlets.clear();
+    mesh.indices.clear();
+    mesh.indices.reserve(triangleCount * 3);
+
+    // The triangles around each vertex, and how many of them are still to be placed
+    std::vector<uint32_t> firstTriangle(vertexCount + 1, 0), vertexTriangles(triangleCount * 3);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        ++firstTriangle[indices[i] + 1];
+    for (size_t v = 0; v < vertexCount; ++v)
+        firstTriangle[v + 1] += firstTriangle[v];
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        liveTriangles[v] = firstTriangle[v + 1] - firstTriangle[v];
+    {
+        std::vector<uint32_t> cursor(firstTriangle.begin(), firstTriangle.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; ++i)
+            vertexTriangles[cursor[indices[i]]++] = (uint32_t)(i / 3);
+    }
+
+    std::vector<bool> placed(triangleCount, false);
+    // Where each vertex is in the current meshlet, or ~0 when it is not in it
+    std::vector<uint32_t> slot(vertexCount, ~0u);
+    std::vector<uint32_t> vertices, previousVertices;
+    vertices.reserve(MESHLET_MAX_VERTICES);
+    size_t meshletTriangles = 0, firstIndex = 0, scan = 0;
+    glm::vec3 positionSum(0.0f);
+
+    for (size_t remaining = triangleCount; remaining > 0;)
+    {
+        int64_t best = -1;
+        unsigned bestNew = 4;
+        if (vertices.empty())
+        {
+            // Start beside the last meshlet, on the triangle whose corners have the fewest triangles left
+            // around them, so the mesh is eaten from its edges inward rather than leaving islands
+            uint32_t bestLive = ~0u;
+            for (uint32_t v : previousVertices)
+            {
+                for (uint32_t i = firstTriangle[v]; i < firstTriangle[v + 1]; ++i)
+                {
+                    uint32_t t = vertexTriangles[i];
+                    if (placed[t]) continue;
+                    const uint32_t* corners = indices + t * 3;
+                    uint32_t live = liveTriangles[corners[0]] + liveTriangles[corners[1]] + liveTriangles[corners[2]];
+                    if (live < bestLive)
+                    {
+                        best = t;
+                        bestLive = live;
+                    }
+                }
+            }
+            bestNew = 3;
+        }
+        else
+        {
+            glm::vec3 centre = positionSum * (1.0f / (float)vertices.size());
+            float bestDistance = FLT_MAX;
+            for (uint32_t v : vertices)
+            {
+                for (uint32_t i = firstTriangle[v]; i < firstTriangle[v + 1]; ++i)
+                {
+                    uint32_t t = vertexTriangles[i];
+                    if (placed[t]) continue;
+                    const uint32_t* corners = indices + t * 3;
+                    unsigned newVertices = (slot[corners[0]] == ~0u) + (slot[corners[1]] == ~0u) + (slot[corners[2]] == ~0u);
+                    if (newVertices > bestNew) continue;
+                    glm::vec3 middle = (Position(positions, positionStride, corners[0]) + Position(positions, positionStride, corners[1]) +
+                        Position(positions, positionStride, corners[2])) * (1.0f / 3.0f);
+                    glm::vec3 offset = middle - centre;
+                    float distance = glm::dot(offset, offset);
+                    if (newVertices < bestNew || distance < bestDistance)
+                    {
+                        best = t;
+                        bestNew = newVertices;
+                        bestDistance = distance;
+                    }
+                }
+            }
+        }
+        if (best < 0)
+        {
+            // Nothing joins on; carry on from the next triangle in the list's own order
+            while (placed[scan]) ++scan;
+            best = (int64_t)scan;
+            const uint32_t* corners = indices + scan * 3;
+            bestNew = (slot[corners[0]] == ~0u) + (slot[corners[1]] == ~0u) + (slot[corners[2]] == ~0u);
+        }
+
+        if (vertices.size() + bestNew > MESHLET_MAX_VERTICES || meshletTriangles == MESHLET_MAX_TRIANGLES)
+        {
+            // Full: close this meshlet and pick again for the next
+            mesh.meshlets.push_back(MeshletBounds(mesh, (GLuint)firstIndex, (GLuint)(meshletTriangles * 3), (GLuint)vertices.size(), positions, positionStride));
+            for (uint32_t v : vertices) slot[v] = ~0u;
+            previousVertices.swap(vertices);
+            vertices.clear();
+            meshletTriangles = 0;
+            firstIndex = mesh.indices.size();
+            positionSum = glm::vec3(0.0f);
+            continue;
+        }
+
+        const uint32_t* corners = indices + best * 3;
+        for (int k = 0; k < 3; ++k)
+        {
+            uint32_t v = corners[k];
+            if (slot[v] == ~0u)
+            {
+                slot[v] = (uint32_t)vertices.size();
+                vertices.push_back(v);
+                positionSum += Position(positions, positionStride, v);
+            }
+            --liveTriangles[v];
+            mesh.indices.push_back(v);
+        }
+        placed[best] = true;
+        ++meshletTriangles;
+        --remaining;
+    }
+    if (meshletTriangles > 0)
+        mesh.meshlets.push_back(MeshletBounds(mesh, (GLuint)firstIndex, (GLuint)(meshletTriangles * 3), (GLuint)vertices.size(), positions, positionStride));
+}
+
+void CreateMeshletCuller(const MeshletMesh& mesh, MeshletCuller& culler)
+{
+    culler.program = LoadSeparableShaderProgramFile("MeshletCull.comp", GL_COMPUTE_SHADER);
+    culler.meshletCount = (GLuint)mesh.meshlets.size();
+
+    culler.meshletBuffer = CreateBuffer();
+    glNamedBufferStorage(culler.meshletBuffer.get(), mesh.meshlets.size() * sizeof(Meshlet), mesh.meshlets.data(), 0);
+    culler.commandBuffer = CreateBuffer();
+    glNamedBufferStorage(culler.commandBuffer.get(), std::max<size_t>(mesh.meshlets.size(), 1) * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    culler.countBuffer = CreateBuffer();
+    glNamedBufferStorage(culler.countBuffer.get(), sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    err_checkGL("Creating meshlet buffers");
+}
+
+static bool IsDrawCountSupported()
+{
+    return GLEW_VERSION_4_6 || GLEW_ARB_indirect_parameters;
+}
+
+void CullMeshlets(const MeshletCuller& culler, const glm::mat4& MVP, const glm::vec3& cameraPosition)
+{
+    GLuint zero = 0;
+    glClearNamedBufferData(culler.countBuffer.get(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    // Without a draw count, every command is drawn, so the ones past the survivors have to be empty
+    if (!IsDrawCountSupported())
+        glClearNamedBufferData(culler.commandBuffer.get(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    GLuint program = culler.program.get();
+    glProgramUniformMatrix4fv(program, 0, 1, GL_FALSE, &MVP[0][0]);
+    glProgramUniform3fv(program, 1, 1, &cameraPosition[0]);
+    glProgramUniform1ui(program, 2, culler.meshletCount);
+    glUseProgram(program);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MESHLET_BINDING, culler.meshletBuffer.get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MESHLET_COMMAND_BINDING, culler.commandBuffer.get());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MESHLET_COUNT_BINDING, culler.countBuffer.get());
+    glDispatchCompute((culler.meshletCount + MESHLET_CULL_GROUP_SIZE - 1) / MESHLET_CULL_GROUP_SIZE, 1, 1);
+    // The commands and count are read by the draw, not by shaders
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+    err_checkGL("Culling meshlets");
+}
+
+void DrawMeshlets(const MeshletCuller& culler, GLenum indexType)
+{
+    // The cone test dropped clusters seen only from behind, so back faces must not show anywhere else either
+    GLboolean culling = glIsEnabled(GL_CULL_FACE);
+    if (!culling)
+        glEnable(GL_CULL_FACE);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler.commandBuffer.get());
+    if (GLEW_VERSION_4_6)
+    {
+        glBindBuffer(GL_PARAMETER_BUFFER, culler.countBuffer.get());
+        glMultiDrawElementsIndirectCount(GL_TRIANGLES, indexType, 0, 0, culler.meshletCount, sizeof(DrawElementsIndirectCommand));
+    }
+    else if (GLEW_ARB_indirect_parameters)
+    {
+        glBindBuffer(GL_PARAMETER_BUFFER_ARB, culler.countBuffer.get());
+        glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, indexType, 0, 0, culler.meshletCount, sizeof(DrawElementsIndirectCommand));
+    }
+    else
+    {
+        glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, 0, culler.meshletCount, sizeof(DrawElementsIndirectCommand));
+    }
+
+    if (!culling)
+        glDisable(GL_CULL_FACE);
+}
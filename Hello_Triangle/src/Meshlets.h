@@ -0,0 +1,74 @@
+#ifndef __Meshlets_h__
+#define __Meshlets_h__
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "GLObjects.h"
+
+// Meshlets: a mesh cut into small clusters of neighbouring triangles, each with a bounding sphere and a cone
+// holding its normals. A compute pass (data/MeshletCull.comp) tests every cluster against the view frustum
+// and the cone against the camera, and writes a DrawElementsIndirectCommand for each one left, so clusters
+// that are off screen or facing away never reach the rasterizer.
+
+// Cluster sizes; 64 vertices and 124 triangles fit the mesh shader limits of current hardware
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+// Storage buffer binding points MeshletCull.comp uses
+const GLuint MESHLET_BINDING = 0;         // the Meshlets
+const GLuint MESHLET_COMMAND_BINDING = 1; // a DrawElementsIndirectCommand per surviving meshlet
+const GLuint MESHLET_COUNT_BINDING = 2;   // how many survived
+
+// Invocations per work group in MeshletCull.comp
+const GLuint MESHLET_CULL_GROUP_SIZE = 64;
+
+// One cluster, in model space; matches struct Meshlet in MeshletCull.comp (std430)
+struct Meshlet
+{
+    glm::vec4 sphere;   // centre, radius
+    glm::vec4 coneApex; // w is unused
+    glm::vec4 cone;     // axis, cutoff: every triangle faces away from a camera where
+                        // dot(normalize(apex - camera), axis) >= cutoff. Above 1 when the normals spread too far
+    GLuint firstIndex;  // where the cluster's triangles are in MeshletMesh::indices
+    GLuint indexCount;
+    GLuint vertexCount; // distinct vertices
+    GLuint padding;
+};
+static_assert(sizeof(Meshlet) == 64, "Meshlet must match its std430 layout");
+
+struct MeshletMesh
+{
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> indices; // each meshlet's triangles in turn, indexing the original vertices
+};
+
+// Split an indexed triangle list into meshlets
+// Clusters grow by the triangles adding the fewest new vertices, nearest the cluster's centre first, and
+// new clusters start beside the last one. positions points at the first vertex's x, y, z floats,
+// positionStride bytes apart
+void BuildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, MeshletMesh& mesh);
+
+// The GPU side of one mesh's meshlets
+struct MeshletCuller
+{
+    Program program;
+    Buffer meshletBuffer;
+    Buffer commandBuffer; // survivors first; the rest are left zeroed, so they draw nothing
+    Buffer countBuffer;   // the survivor count, read as a GL_PARAMETER_BUFFER where that is supported
+    GLuint meshletCount = 0;
+};
+
+// Upload the meshlets and load the culling shader
+void CreateMeshletCuller(const MeshletMesh& mesh, MeshletCuller& culler);
+
+// Cull against the frustum of MVP and a camera at cameraPosition in model space
+void CullMeshlets(const MeshletCuller& culler, const glm::mat4& MVP, const glm::vec3& cameraPosition);
+
+// Draw the survivors of the last CullMeshlets; the vertex array must be bound, with an element buffer
+// holding MeshletMesh::indices as indexType. Back faces are culled for the draw, as the cone test assumes:
+// counter-clockwise triangles face the camera
+void DrawMeshlets(const MeshletCuller& culler, GLenum indexType);
+
+#endif
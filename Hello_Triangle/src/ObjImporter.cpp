@@ -0,0 +1,367 @@
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include "Data.h"
+#include "MappedFile.h"
+#include "ObjImporter.h"
+
+// Face corners as read: indices into the positions, uvs and normals, 0-based
+// A corner that counts back from the end of a list (a negative OBJ index) is stored as RELATIVE | n,
+// where n is a 31-bit signed index from the start of the chunk; it can reach back into earlier chunks.
+// Once every chunk's counts are known, the chunk's starting count turns n into an absolute index
+// Absolute indices are below RELATIVE, and the one just below it means there is no index at all
+static const uint32_t RELATIVE = 0x80000000u;
+static const uint32_t MISSING = 0x7FFFFFFFu;
+
+struct ObjCorner
+{
+    uint32_t position;
+    uint32_t uv;
+    uint32_t normal;
+};
+
+// Everything one thread read from its chunk
+struct ObjChunk
+{
+    const char* begin;
+    const char* end;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjCorner> corners; // three per triangle
+    bool failed = false;
+};
+
+static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool IsDigit(char c)
+{
+    return (unsigned char)(c - '0') < 10;
+}
+
+static inline const char* SkipSpaces(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    return p;
+}
+
+// Decimal floats without strtod: no locale and no allocation. Up to 19 significant digits are kept,
+// which is more than a float can tell apart; any after that only scale the result
+static const char* ParseFloat(const char* p, const char* end, float* value)
+{
+    p = SkipSpaces(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    for (; p < end && IsDigit(*p); ++p)
+    {
+        if (digits < 19) { mantissa = mantissa * 10 + (uint64_t)(*p - '0'); ++digits; }
+        else ++exponent;
+    }
+    if (p < end && *p == '.')
+    {
+        for (++p; p < end && IsDigit(*p); ++p)
+        {
+            if (digits < 19) { mantissa = mantissa * 10 + (uint64_t)(*p - '0'); ++digits; --exponent; }
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* q = p + 1;
+        bool negativeExponent = false;
+        if (q < end && (*q == '-' || *q == '+'))
+        {
+            negativeExponent = *q == '-';
+            ++q;
+        }
+        if (q < end && IsDigit(*q))
+        {
+            int written = 0;
+            for (; q < end && IsDigit(*q); ++q)
+                if (written < 1000) written = written * 10 + (*q - '0');
+            exponent += negativeExponent ? -written : written;
+            p = q;
+        }
+    }
+
+    double result = (double)mantissa;
+    if (exponent < 0)
+    {
+        for (; exponent < -22; exponent += 22) result /= 1e22;
+        result /= powersOfTen[-exponent];
+    }
+    else
+    {
+        for (; exponent > 22; exponent -= 22) result *= 1e22;
+        result *= powersOfTen[exponent];
+    }
+    *value = (float)(negative ? -result : result);
+    return p;
+}
+
+// One index of a face corner; returns MISSING when the field is empty, as in "1//3"
+static const char* ParseIndex(const char* p, const char* end, uint32_t seen, uint32_t* index)
+{
+    bool negative = false;
+    if (p < end && *p == '-')
+    {
+        negative = true;
+        ++p;
+    }
+    if (p == end || !IsDigit(*p))
+    {
+        *index = MISSING;
+        return p;
+    }
+    uint32_t value = 0;
+    for (; p < end && IsDigit(*p); ++p)
+        value = value * 10 + (uint32_t)(*p - '0');
+    if (!negative && (value == 0 || value > MISSING))
+    {
+        *index = MISSING;
+        return p;
+    }
+    *index = negative ? RELATIVE | ((seen - value) & ~RELATIVE) : value - 1;
+    return p;
+}
+
+static void ParseChunk(ObjChunk& chunk)
+{
+    const char* p = chunk.begin;
+    const char* end = chunk.end;
+    // Reused for every face, so it only grows for the largest polygon in the chunk
+    std::vector<ObjCorner> polygon;
+    while (p < end)
+    {
+        const char* lineEnd = (const char*)memchr(p, '\n', (size_t)(end - p));
+        if (lineEnd == nullptr) lineEnd = end;
+        p = SkipSpaces(p, lineEnd);
+
+        if (lineEnd - p > 2 && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            glm::vec3 position;
+            p = ParseFloat(p + 2, lineEnd, &position.x);
+            p = ParseFloat(p, lineEnd, &position.y);
+            ParseFloat(p, lineEnd, &position.z);
+            chunk.positions.push_back(position);
+        }
+        else if (lineEnd - p > 3 && p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+        {
+            glm::vec2 uv;
+            p = ParseFloat(p + 3, lineEnd, &uv.x);
+            ParseFloat(p, lineEnd, &uv.y);
+            chunk.uvs.push_back(uv);
+        }
+        else if (lineEnd - p > 3 && p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+        {
+            glm::vec3 normal;
+            p = ParseFloat(p + 3, lineEnd, &normal.x);
+            p = ParseFloat(p, lineEnd, &normal.y);
+            ParseFloat(p, lineEnd, &normal.z);
+            chunk.normals.push_back(normal);
+        }
+        else if (lineEnd - p > 2 && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            polygon.clear();
+            p = SkipSpaces(p + 2, lineEnd);
+            while (p < lineEnd && *p != '\r' && *p != '#')
+            {
+                ObjCorner corner;
+                p = ParseIndex(p, lineEnd, (uint32_t)chunk.positions.size(), &corner.position);
+                corner.uv = corner.normal = MISSING;
+                if (p < lineEnd && *p == '/')
+                    p = ParseIndex(p + 1, lineEnd, (uint32_t)chunk.uvs.size(), &corner.uv);
+                if (p < lineEnd && *p == '/')
+                    p = ParseIndex(p + 1, lineEnd, (uint32_t)chunk.normals.size(), &corner.normal);
+                if (corner.position == MISSING || (p < lineEnd && *p != ' ' && *p != '\t' && *p != '\r'))
+                {
+                    chunk.failed = true;
+                    break;
+                }
+                polygon.push_back(corner);
+                p = SkipSpaces(p, lineEnd);
+            }
+            // Fan out from the first corner
+            for (size_t i = 2; i < polygon.size(); ++i)
+            {
+                chunk.corners.push_back(polygon[0]);
+                chunk.corners.push_back(polygon[i - 1]);
+                chunk.corners.push_back(polygon[i]);
+            }
+        }
+        p = lineEnd < end ? lineEnd + 1 : end;
+    }
+}
+
+// Turn a chunk-relative index into an absolute one, and check it is in range
+static bool ResolveIndex(uint32_t& index, uint32_t chunkStart, uint32_t total)
+{
+    if (index == MISSING) return true;
+    if (index & RELATIVE)
+    {
+        // Sign extend the 31-bit chunk index
+        int64_t absolute = (int64_t)chunkStart + (int32_t)(index << 1) / 2;
+        if (absolute < 0) return false;
+        index = (uint32_t)absolute;
+    }
+    return index < total;
+}
+
+// Open addressing on the position/uv/normal triple, so each distinct corner becomes one vertex
+static uint64_t CornerHash(const ObjCorner& corner)
+{
+    uint64_t hash = ((uint64_t)corner.position * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)corner.uv * 0xC2B2AE3D27D4EB4Full) ^ ((uint64_t)corner.normal * 0x165667B19E3779F9ull);
+    return hash ^ (hash >> 29);
+}
+
+bool ImportObjSource(const char* source, size_t size, ObjMesh& mesh, unsigned threadCount)
+{
+    mesh.vertices.clear();
+    mesh.indices.clear();
+
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    // Small files are not worth the threads
+    size_t chunkCount = size / (256 * 1024) + 1;
+    if (chunkCount > threadCount) chunkCount = threadCount;
+    if (chunkCount == 0) chunkCount = 1;
+
+    // Cut at line ends, so no line is split between chunks
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* end = source + size;
+    const char* begin = source;
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        const char* chunkEnd = i + 1 == chunkCount ? end : source + size * (i + 1) / chunkCount;
+        if (chunkEnd < begin) chunkEnd = begin;
+        const char* newline = (const char*)memchr(chunkEnd, '\n', (size_t)(end - chunkEnd));
+        chunkEnd = newline == nullptr ? end : newline + 1;
+        chunks[i].begin = begin;
+        chunks[i].end = chunkEnd;
+        begin = chunkEnd;
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < chunkCount; ++i)
+        threads.emplace_back(ParseChunk, std::ref(chunks[i]));
+    ParseChunk(chunks[0]);
+    for (std::thread& thread : threads)
+        thread.join();
+
+    // Gather the attributes, resolving each chunk's indices against where it starts
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<ObjCorner> corners;
+    size_t positionTotal = 0, uvTotal = 0, normalTotal = 0, cornerTotal = 0;
+    for (const ObjChunk& chunk : chunks)
+    {
+        if (chunk.failed)
+        {
+            fprintf(stderr, "Malformed face in OBJ\n");
+            return false;
+        }
+        positionTotal += chunk.positions.size();
+        uvTotal += chunk.uvs.size();
+        normalTotal += chunk.normals.size();
+        cornerTotal += chunk.corners.size();
+    }
+    positions.reserve(positionTotal);
+    uvs.reserve(uvTotal);
+    normals.reserve(normalTotal);
+    corners.reserve(cornerTotal);
+    for (ObjChunk& chunk : chunks)
+    {
+        uint32_t positionStart = (uint32_t)positions.size();
+        uint32_t uvStart = (uint32_t)uvs.size();
+        uint32_t normalStart = (uint32_t)normals.size();
+        for (ObjCorner& corner : chunk.corners)
+        {
+            if (!ResolveIndex(corner.position, positionStart, (uint32_t)positionTotal)
+                || !ResolveIndex(corner.uv, uvStart, (uint32_t)uvTotal)
+                || !ResolveIndex(corner.normal, normalStart, (uint32_t)normalTotal))
+            {
+                fprintf(stderr, "OBJ face refers to an element that does not exist\n");
+                return false;
+            }
+        }
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+        normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+        corners.insert(corners.end(), chunk.corners.begin(), chunk.corners.end());
+        std::vector<ObjCorner>().swap(chunk.corners);
+    }
+
+    // Deduplicate corners into vertices; the table is kept at most half full
+    size_t capacity = 16;
+    while (capacity < corners.size() * 2) capacity *= 2;
+    std::vector<uint32_t> slots(capacity, MISSING);
+    std::vector<ObjCorner> unique;
+    mesh.indices.reserve(corners.size());
+    for (const ObjCorner& corner : corners)
+    {
+        size_t slot = CornerHash(corner) & (capacity - 1);
+        for (;;)
+        {
+            uint32_t vertex = slots[slot];
+            if (vertex == MISSING)
+            {
+                vertex = (uint32_t)unique.size();
+                slots[slot] = vertex;
+                unique.push_back(corner);
+                mesh.indices.push_back(vertex);
+                break;
+            }
+            const ObjCorner& other = unique[vertex];
+            if (other.position == corner.position && other.uv == corner.uv && other.normal == corner.normal)
+            {
+                mesh.indices.push_back(vertex);
+                break;
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+    }
+
+    mesh.vertices.resize(unique.size());
+    for (size_t i = 0; i < unique.size(); ++i)
+    {
+        ObjVertex& vertex = mesh.vertices[i];
+        vertex.position = positions[unique[i].position];
+        vertex.uv = unique[i].uv == MISSING ? glm::vec2(0.0f, 0.0f) : uvs[unique[i].uv];
+        vertex.normal = unique[i].normal == MISSING ? glm::vec3(0.0f, 0.0f, 0.0f) : normals[unique[i].normal];
+    }
+    return true;
+}
+
+bool ImportObj(const char* filePath, ObjMesh& mesh, unsigned threadCount)
+{
+    const void* packedData;
+    size_t packedSize;
+    if (findPackedFile(filePath, &packedData, &packedSize))
+        return ImportObjSource((const char*)packedData, packedSize, mesh, threadCount);
+
+    size_t size = 0;
+    const unsigned char* data = MapFile(filePath, &size, true);
+    if (data == nullptr)
+        data = MapFile(DataPathToFilePath(filePath).c_str(), &size, true);
+    if (data == nullptr)
+    {
+        fprintf(stderr, "Unable to open %s\n", filePath);
+        return false;
+    }
+
+    bool imported = ImportObjSource((const char*)data, size, mesh, threadCount);
+    if (!imported)
+        fprintf(stderr, "Unable to import %s\n", filePath);
+    UnmapFile(data, size);
+    return imported;
+}
@@ -0,0 +1,40 @@
+#ifndef __ObjImporter_h__
+#define __ObjImporter_h__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+#include "VertexLayout.h"
+
+// Wavefront OBJ import into indexed triangle lists
+// Only geometry is read: v, vt, vn and f. Polygons are split into fans, and each distinct
+// position/uv/normal combination becomes one vertex. Missing uvs and normals are left zero.
+
+struct ObjVertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+
+typedef VertexLayout<ObjVertex,
+    VERTEX_ATTRIBUTE(0, ObjVertex, position),
+    VERTEX_ATTRIBUTE(1, ObjVertex, normal),
+    VERTEX_ATTRIBUTE(2, ObjVertex, uv)> ObjVertexLayout;
+
+// Ready for glNamedBufferData: vertices into the vertex buffer, indices into the element buffer
+struct ObjMesh
+{
+    std::vector<ObjVertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// Import an OBJ file, found the same way as loadFile. The file is mapped, cut into chunks at line
+// boundaries, and the chunks are parsed on threadCount threads (0 for one per core).
+// Returns false, having reported why, if the file is missing or refers to elements it does not have
+bool ImportObj(const char* filePath, ObjMesh& mesh, unsigned threadCount = 0);
+// The same, from OBJ text already in memory
+bool ImportObjSource(const char* source, size_t size, ObjMesh& mesh, unsigned threadCount = 0);
+
+#endif
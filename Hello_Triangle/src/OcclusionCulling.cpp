@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <float.h>
+#include <functional>
+#include <math.h>
+#include "OcclusionCulling.h"
+#include "SimdLanes.h"
+#include "WorkerPool.h"
+
+// Boxes tested by one worker at a time
+const size_t OCCLUSION_TEST_BLOCK_SIZE = 256;
+
+// Clip space sides triangles are clipped against, as dot(plane, vertex) >= 0: near, left, right, bottom,
+// top. The far side is left alone; anything past it is deeper than the cleared buffer and never written
+static const glm::vec4 clipPlanes[5] = {
+    glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),
+    glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),
+    glm::vec4(-1.0f, 0.0f, 0.0f, 1.0f),
+    glm::vec4(0.0f, 1.0f, 0.0f, 1.0f),
+    glm::vec4(0.0f, -1.0f, 0.0f, 1.0f)
+};
+
+// Each side adds at most one vertex
+const int MAX_CLIPPED_VERTICES = 3 + 5;
+
+void ResizeOcclusionBuffer(OcclusionBuffer& buffer, int width, int height)
+{
+    buffer.width = std::max((width + OCCLUSION_BAND_HEIGHT - 1) / OCCLUSION_BAND_HEIGHT, 1) * OCCLUSION_BAND_HEIGHT;
+    buffer.height = std::max((height + OCCLUSION_BAND_HEIGHT - 1) / OCCLUSION_BAND_HEIGHT, 1) * OCCLUSION_BAND_HEIGHT;
+    buffer.levels.clear();
+    int levelWidth = buffer.width, levelHeight = buffer.height;
+    for (;;)
+    {
+        buffer.levels.emplace_back();
+        OcclusionLevel& level = buffer.levels.back();
+        level.width = levelWidth;
+        level.height = levelHeight;
+        // Nothing is hidden until the first occluders are rasterized
+        level.depth.assign((size_t)levelWidth * levelHeight, 1.0f);
+        if (levelWidth == 1 && levelHeight == 1) break;
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+}
+
+void BeginOcclusionFrame(OcclusionBuffer& buffer, const glm::mat4& viewProjection)
+{
+    buffer.viewProjection = viewProjection;
+    buffer.triangles.clear();
+}
+
+static float Dot(const glm::vec4& a, const glm::vec4& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+// Sutherland-Hodgman against every side in clipPlanes; returns the vertices left, 0 once fewer than 3 remain
+static int ClipPolygon(glm::vec4* polygon, int count)
+{
+    glm::vec4 clipped[MAX_CLIPPED_VERTICES];
+    for (const glm::vec4& plane : clipPlanes)
+    {
+        int kept = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            const glm::vec4& a = polygon[i];
+            const glm::vec4& b = polygon[(i + 1) % count];
+            float da = Dot(plane, a), db = Dot(plane, b);
+            if (da >= 0.0f) clipped[kept++] = a;
+            if ((da >= 0.0f) != (db >= 0.0f)) clipped[kept++] = a + (b - a) * (da / (da - db));
+        }
+        if (kept < 3) return 0;
+        std::copy(clipped, clipped + kept, polygon);
+        count = kept;
+    }
+    return count;
+}
+
+// Project a triangle that is inside every side in clipPlanes and queue it
+static void SetupTriangle(OcclusionBuffer& buffer, const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2)
+{
+    const glm::vec4* clip[3] = { &v0, &v1, &v2 };
+    float x[3], y[3], z[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        float inverseW = 1.0f / clip[i]->w;
+        x[i] = (clip[i]->x * inverseW * 0.5f + 0.5f) * (float)buffer.width;
+        y[i] = (clip[i]->y * inverseW * 0.5f + 0.5f) * (float)buffer.height;
+        z[i] = clip[i]->z * inverseW * 0.5f + 0.5f;
+    }
+    // Occluders are solid, so both faces are drawn; the edges are set up for counter-clockwise order
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (fabsf(area) < 1e-6f) return;
+    if (area < 0.0f)
+    {
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        std::swap(z[1], z[2]);
+        area = -area;
+    }
+
+    OcclusionTriangle t;
+    t.minX = std::max((int)ceilf(std::min(std::min(x[0], x[1]), x[2]) - 0.5f), 0);
+    t.maxX = std::min((int)floorf(std::max(std::max(x[0], x[1]), x[2]) - 0.5f), buffer.width - 1);
+    t.minY = std::max((int)ceilf(std::min(std::min(y[0], y[1]), y[2]) - 0.5f), 0);
+    t.maxY = std::min((int)floorf(std::max(std::max(y[0], y[1]), y[2]) - 0.5f), buffer.height - 1);
+    if (t.minX > t.maxX || t.minY > t.maxY) return;
+
+    // Edge functions and depth are evaluated at pixel centres, half a pixel from the integer coordinates
+    for (int i = 0; i < 3; ++i)
+    {
+        int j = (i + 1) % 3;
+        t.edgeX[i] = y[i] - y[j];
+        t.edgeY[i] = x[j] - x[i];
+        t.edgeC[i] = -t.edgeX[i] * x[i] - t.edgeY[i] * y[i] + 0.5f * (t.edgeX[i] + t.edgeY[i]);
+    }
+    t.depthX = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+    t.depthY = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+    // Pushed back to the farthest the triangle gets within the pixel, so a pixel never hides more than it should
+    t.depthC = z[0] - t.depthX * x[0] - t.depthY * y[0] + 0.5f * (t.depthX + t.depthY) + 0.5f * (fabsf(t.depthX) + fabsf(t.depthY));
+    buffer.triangles.push_back(t);
+}
+
+void AddOccluder(OcclusionBuffer& buffer, const glm::mat4& model, const float* positions, size_t vertexCount, size_t positionStride,
+    const uint32_t* indices, size_t indexCount)
+{
+    glm::mat4 modelViewProjection = buffer.viewProjection * model;
+    std::vector<glm::vec4> clip(vertexCount);
+    std::vector<uint8_t> outside(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        const float* p = (const float*)((const char*)positions + v * positionStride);
+        clip[v] = modelViewProjection * glm::vec4(p[0], p[1], p[2], 1.0f);
+        outside[v] = 0;
+        for (int plane = 0; plane < 5; ++plane)
+            outside[v] |= (uint8_t)((Dot(clipPlanes[plane], clip[v]) < 0.0f) << plane);
+    }
+
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        if (a >= vertexCount || b >= vertexCount || c >= vertexCount) continue;
+        // Entirely outside one side: nothing to draw. Entirely inside all of them: nothing to clip
+        if (outside[a] & outside[b] & outside[c]) continue;
+        if ((outside[a] | outside[b] | outside[c]) == 0)
+        {
+            SetupTriangle(buffer, clip[a], clip[b], clip[c]);
+            continue;
+        }
+        glm::vec4 polygon[MAX_CLIPPED_VERTICES] = { clip[a], clip[b], clip[c] };
+        int count = ClipPolygon(polygon, 3);
+        for (int v = 2; v < count; ++v)
+            SetupTriangle(buffer, polygon[0], polygon[v - 1], polygon[v]);
+    }
+}
+
+// Fill rows [firstRow, endRow) of level with the farthest of the 2x2 texels under each of its texels
+static void ReduceLevel(const OcclusionLevel& below, OcclusionLevel& level, int firstRow, int endRow)
+{
+    for (int y = firstRow; y < endRow; ++y)
+    {
+        const float* row0 = &below.depth[(size_t)(y * 2) * below.width];
+        const float* row1 = &below.depth[(size_t)std::min(y * 2 + 1, below.height - 1) * below.width];
+        float* out = &level.depth[(size_t)y * level.width];
+        for (int x = 0; x < level.width; ++x)
+        {
+            int x0 = x * 2, x1 = std::min(x * 2 + 1, below.width - 1);
+            out[x] = std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+        }
+    }
+}
+
+static void RasterizeBand(OcclusionBuffer& buffer, int band)
+{
+    OcclusionLevel& pixels = buffer.levels[0];
+    int firstRow = band * OCCLUSION_BAND_HEIGHT, lastRow = firstRow + OCCLUSION_BAND_HEIGHT - 1;
+    std::fill(pixels.depth.begin() + (size_t)firstRow * pixels.width, pixels.depth.begin() + (size_t)(lastRow + 1) * pixels.width, 1.0f);
+
+    for (const OcclusionTriangle& t : buffer.triangles)
+    {
+        int minY = std::max(t.minY, firstRow), maxY = std::min(t.maxY, lastRow);
+        if (minY > maxY) continue;
+#if SIMD_LANES > 1
+        // Rows start on a whole vector, and the width is a multiple of one, so every load and store is
+        // within the row; lanes outside the triangle fail an edge test
+        int startX = t.minX / SIMD_LANES * SIMD_LANES;
+        Lanes laneEdge[3], stepEdge[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            laneEdge[i] = Add(Splat(t.edgeX[i] * startX + t.edgeC[i]), Mul(Splat(t.edgeX[i]), LaneIndices()));
+            stepEdge[i] = Splat(t.edgeX[i] * SIMD_LANES);
+        }
+        Lanes laneDepth = Add(Splat(t.depthX * startX + t.depthC), Mul(Splat(t.depthX), LaneIndices()));
+        Lanes stepDepth = Splat(t.depthX * SIMD_LANES);
+        for (int y = minY; y <= maxY; ++y)
+        {
+            float* row = &pixels.depth[(size_t)y * pixels.width];
+            Lanes edge0 = Add(laneEdge[0], Splat(t.edgeY[0] * y));
+            Lanes edge1 = Add(laneEdge[1], Splat(t.edgeY[1] * y));
+            Lanes edge2 = Add(laneEdge[2], Splat(t.edgeY[2] * y));
+            Lanes depth = Add(laneDepth, Splat(t.depthY * y));
+            for (int x = startX; x <= t.maxX; x += SIMD_LANES)
+            {
+                Lanes inside = And(And(AtLeastZero(edge0), AtLeastZero(edge1)), AtLeastZero(edge2));
+                Lanes stored = Load(row + x);
+                Store(row + x, Select(inside, Min(stored, depth), stored));
+                edge0 = Add(edge0, stepEdge[0]);
+                edge1 = Add(edge1, stepEdge[1]);
+                edge2 = Add(edge2, stepEdge[2]);
+                depth = Add(depth, stepDepth);
+            }
+        }
+#else
+        for (int y = minY; y <= maxY; ++y)
+        {
+            float* row = &pixels.depth[(size_t)y * pixels.width];
+            for (int x = t.minX; x <= t.maxX; ++x)
+            {
+                bool inside = true;
+                for (int i = 0; i < 3; ++i)
+                    inside = inside && t.edgeX[i] * x + t.edgeY[i] * y + t.edgeC[i] >= 0.0f;
+                if (inside)
+                    row[x] = std::min(row[x], t.depthX * x + t.depthY * y + t.depthC);
+            }
+        }
+#endif
+    }
+
+    // The levels whose texels cover only this band's rows
+    for (int level = 1; (OCCLUSION_BAND_HEIGHT >> level) > 0 && level < (int)buffer.levels.size(); ++level)
+    {
+        int rows = OCCLUSION_BAND_HEIGHT >> level;
+        ReduceLevel(buffer.levels[level - 1], buffer.levels[level], band * rows, (band + 1) * rows);
+    }
+}
+
+void RasterizeOccluders(OcclusionBuffer& buffer, bool parallel)
+{
+    if (buffer.levels.empty()) return;
+    size_t bandCount = (size_t)(buffer.height / OCCLUSION_BAND_HEIGHT);
+    std::function<void(size_t, size_t)> rasterize = [&](size_t begin, size_t end) {
+        for (size_t band = begin; band < end; ++band)
+            RasterizeBand(buffer, (int)band);
+    };
+    if (parallel)
+        ParallelFor(bandCount, 1, rasterize);
+    else
+        rasterize(0, bandCount);
+
+    // The rest are a few hundred texels at most
+    int level = 1;
+    while ((OCCLUSION_BAND_HEIGHT >> level) > 0) ++level;
+    for (; level < (int)buffer.levels.size(); ++level)
+        ReduceLevel(buffer.levels[level - 1], buffer.levels[level], 0, buffer.levels[level].height);
+}
+
+// Whether anything at depth could show in a pixel of rect (x0, y0, x1, y1, inclusive) under texel (x, y) of level
+static bool AnyFarther(const OcclusionBuffer& buffer, int level, int x, int y, const int rect[4], float depth)
+{
+    const OcclusionLevel& texels = buffer.levels[level];
+    if (texels.depth[(size_t)y * texels.width + x] < depth) return false;
+    if (level == 0) return true;
+
+    const OcclusionLevel& below = buffer.levels[level - 1];
+    int shift = level - 1;
+    for (int childY = y * 2; childY <= y * 2 + 1 && childY < below.height; ++childY)
+    {
+        if ((childY << shift) > rect[3] || ((childY + 1) << shift) <= rect[1]) continue;
+        for (int childX = x * 2; childX <= x * 2 + 1 && childX < below.width; ++childX)
+        {
+            if ((childX << shift) > rect[2] || ((childX + 1) << shift) <= rect[0]) continue;
+            if (AnyFarther(buffer, level - 1, childX, childY, rect, depth)) return true;
+        }
+    }
+    return false;
+}
+
+bool IsAabbOccluded(const OcclusionBuffer& buffer, const glm::vec3& low, const glm::vec3& high)
+{
+    if (buffer.levels.empty()) return false;
+
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearest = FLT_MAX;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        glm::vec4 p = buffer.viewProjection * glm::vec4(corner & 1 ? high.x : low.x, corner & 2 ? high.y : low.y, corner & 4 ? high.z : low.z, 1.0f);
+        // A corner in front of the near plane has no place on the screen, and the box may be around the camera
+        if (p.z < -p.w) return false;
+        float inverseW = 1.0f / p.w;
+        float x = (p.x * inverseW * 0.5f + 0.5f) * (float)buffer.width;
+        float y = (p.y * inverseW * 0.5f + 0.5f) * (float)buffer.height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::min(nearest, p.z * inverseW * 0.5f + 0.5f);
+    }
+    if (maxX < 0.0f || maxY < 0.0f || minX >= (float)buffer.width || minY >= (float)buffer.height) return true;
+    int rect[4] = {
+        std::max((int)floorf(std::max(minX, 0.0f)), 0),
+        std::max((int)floorf(std::max(minY, 0.0f)), 0),
+        std::min((int)floorf(std::min(maxX, (float)buffer.width)), buffer.width - 1),
+        std::min((int)floorf(std::min(maxY, (float)buffer.height)), buffer.height - 1)
+    };
+
+    // Start from the level where the box spans a few texels each way
+    int size = std::max(rect[2] - rect[0], rect[3] - rect[1]);
+    int level = 0;
+    while ((size >> level) > 1 && level + 1 < (int)buffer.levels.size()) ++level;
+    for (int y = rect[1] >> level; y <= rect[3] >> level; ++y)
+        for (int x = rect[0] >> level; x <= rect[2] >> level; ++x)
+            if (AnyFarther(buffer, level, x, y, rect, nearest))
+                return false;
+    return true;
+}
+
+size_t CullOccludedAabbs(const OcclusionBuffer& buffer, const CullingAabbs& bounds, std::vector<uint32_t>& visible, bool parallel)
+{
+    std::vector<uint8_t> occluded(visible.size());
+    std::function<void(size_t, size_t)> test = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            uint32_t object = visible[i];
+            glm::vec3 center(bounds.centerX[object], bounds.centerY[object], bounds.centerZ[object]);
+            glm::vec3 extent(bounds.extentX[object], bounds.extentY[object], bounds.extentZ[object]);
+            occluded[i] = IsAabbOccluded(buffer, center - extent, center + extent);
+        }
+    };
+    if (parallel)
+        ParallelFor(visible.size(), OCCLUSION_TEST_BLOCK_SIZE, test);
+    else
+        test(0, visible.size());
+
+    size_t kept = 0;
+    for (size_t i = 0; i < visible.size(); ++i)
+    {
+        visible[kept] = visible[i];
+        kept += !occluded[i];
+    }
+    visible.resize(kept);
+    return kept;
+}
@@ -0,0 +1,69 @@
+#ifndef __OcclusionCulling_h__
+#define __OcclusionCulling_h__
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+#include "FrustumCulling.h"
+
+// Occlusion culling on the CPU: a few large occluder meshes are rasterized into a small depth buffer, and
+// objects whose bounds are behind everything drawn there are dropped before their draws are submitted.
+// Nothing touches GL, so it runs the same on machines without a GPU.
+// Rows of pixels are filled SIMD_LANES at a time (see SimdLanes.h), and the buffer is split into bands of
+// rows rasterized on every worker thread (see WorkerPool.h). The depth kept per pixel is the farthest the
+// occluders could be anywhere in it, and above the pixels sits a chain of levels each holding the farthest
+// depth of 2x2 texels of the one below, so a box covering many pixels is usually settled by a few texels.
+
+// Rows per band; each band also builds the first levels above its pixels, so a power of two
+#define OCCLUSION_BAND_HEIGHT 8
+
+// An occluder triangle in pixels, ready to rasterize. Pixel (x, y) is inside when every
+// edgeX[i] * x + edgeY[i] * y + edgeC[i] is at least 0, and gets depthX * x + depthY * y + depthC
+struct OcclusionTriangle
+{
+    float edgeX[3], edgeY[3], edgeC[3];
+    float depthX, depthY, depthC;
+    int minX, minY, maxX, maxY; // pixels it may cover, inclusive
+};
+
+// Depth from 0 at the near plane to 1 at the far one, row 0 at the bottom
+struct OcclusionLevel
+{
+    int width = 0, height = 0;
+    std::vector<float> depth;
+};
+
+struct OcclusionBuffer
+{
+    int width = 0, height = 0; // multiples of OCCLUSION_BAND_HEIGHT
+    glm::mat4 viewProjection;
+    std::vector<OcclusionTriangle> triangles; // added since BeginOcclusionFrame
+    std::vector<OcclusionLevel> levels;       // pixels first, up to a single texel
+};
+
+// Size the buffer in pixels, rounding up to multiples of OCCLUSION_BAND_HEIGHT; a quarter of the window
+// each way is usually plenty
+void ResizeOcclusionBuffer(OcclusionBuffer& buffer, int width, int height);
+
+// Forget the last frame's occluders and look through viewProjection (Projection * View) from now on
+void BeginOcclusionFrame(OcclusionBuffer& buffer, const glm::mat4& viewProjection);
+
+// Clip an indexed triangle list, placed in the world by model, to the view and queue it for rasterizing.
+// positions points at the first vertex's x, y, z floats, positionStride bytes apart. Occluders must be
+// solid: anything behind one of their triangles is taken to be hidden
+void AddOccluder(OcclusionBuffer& buffer, const glm::mat4& model, const float* positions, size_t vertexCount, size_t positionStride,
+    const uint32_t* indices, size_t indexCount);
+
+// Rasterize the queued occluders and build the levels above the pixels. With parallel set, bands of rows
+// are rasterized on every worker thread
+void RasterizeOccluders(OcclusionBuffer& buffer, bool parallel = true);
+
+// Whether the world space box low to high is behind the rasterized occluders everywhere it covers.
+// Boxes that reach in front of the near plane never are; boxes off the screen always are
+bool IsAabbOccluded(const OcclusionBuffer& buffer, const glm::vec3& low, const glm::vec3& high);
+
+// Remove the indices of occluded boxes from visible, which usually holds what CullAabbs left, keeping the
+// rest in order, and return how many remain. With parallel set, the boxes are tested on every worker thread
+size_t CullOccludedAabbs(const OcclusionBuffer& buffer, const CullingAabbs& bounds, std::vector<uint32_t>& visible, bool parallel = true);
+
+#endif
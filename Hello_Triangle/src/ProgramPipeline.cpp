@@ -0,0 +1,41 @@
+#include <stdint.h>
+#include <unordered_map>
+#include "ErrorHandling.h"
+#include "ProgramPipeline.h"
+
+static std::unordered_map<uint64_t, GLuint> pipelines;
+
+static uint64_t PipelineKey(GLuint vertexProgram, GLuint fragmentProgram)
+{
+    return ((uint64_t)vertexProgram << 32) | fragmentProgram;
+}
+
+GLuint GetProgramPipeline(GLuint vertexProgram, GLuint fragmentProgram)
+{
+    GLuint& pipeline = pipelines[PipelineKey(vertexProgram, fragmentProgram)];
+    if (pipeline == 0)
+    {
+        err_checkGL("Before creating program pipeline");
+        glCreateProgramPipelines(1, &pipeline);
+        glUseProgramStages(pipeline, GL_VERTEX_SHADER_BIT, vertexProgram);
+        glUseProgramStages(pipeline, GL_FRAGMENT_SHADER_BIT, fragmentProgram);
+        err_checkGL("Creating program pipeline");
+    }
+    return pipeline;
+}
+
+void ForgetProgramPipelines(GLuint program)
+{
+    for (std::unordered_map<uint64_t, GLuint>::iterator pipeline = pipelines.begin(); pipeline != pipelines.end();)
+    {
+        if ((GLuint)(pipeline->first >> 32) == program || (GLuint)pipeline->first == program)
+        {
+            glDeleteProgramPipelines(1, &pipeline->second);
+            pipeline = pipelines.erase(pipeline);
+        }
+        else
+        {
+            ++pipeline;
+        }
+    }
+}
@@ -0,0 +1,13 @@
+#ifndef __ProgramPipeline_h__
+#define __ProgramPipeline_h__
+
+#include <GL/glew.h>
+
+// Get a program pipeline that runs vertexProgram and fragmentProgram, both made with
+// LoadSeparableShaderProgram*. Pipelines are cached by the pair, so only the first call creates one;
+// after that, switching combinations is just glBindProgramPipeline
+GLuint GetProgramPipeline(GLuint vertexProgram, GLuint fragmentProgram);
+// Delete every cached pipeline that uses a program; DeleteShaderProgram does this for you
+void ForgetProgramPipelines(GLuint program);
+
+#endif
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include "ProgramReflection.h"
+
+static std::unordered_map<GLuint, ProgramReflection> reflections;
+
+static const uint16_t EMPTY_SLOT = 0xFFFF;
+
+static uint32_t SlotHash(ShaderResourceKind kind, uint32_t nameHash)
+{
+    return (nameHash ^ ((uint32_t)kind * 0x9E3779B9u)) * 0x85EBCA6Bu;
+}
+
+static void ReflectInterface(GLuint program, GLenum programInterface, ShaderResourceKind kind, std::vector<ShaderResource>& resources)
+{
+    GLint count = 0;
+    GLint maxNameLength = 0;
+    glGetProgramInterfaceiv(program, programInterface, GL_ACTIVE_RESOURCES, &count);
+    glGetProgramInterfaceiv(program, programInterface, GL_MAX_NAME_LENGTH, &maxNameLength);
+    std::string name(maxNameLength + 1, '\0');
+
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        glGetProgramResourceName(program, programInterface, i, (GLsizei)name.size(), &length, &name[0]);
+        // Arrays are reported as "name[0]"; look them up by "name"
+        if (length > 3 && strcmp(&name[length - 3], "[0]") == 0)
+            length -= 3;
+        name[length] = '\0';
+
+        ShaderResource resource;
+        resource.nameHash = ShaderNameHash(name.c_str());
+        resource.kind = kind;
+        resource.type = 0;
+        resource.location = -1;
+        resource.blockIndex = -1;
+        resource.offset = -1;
+        resource.arraySize = -1;
+        resource.arrayStride = -1;
+        resource.matrixStride = -1;
+        resource.binding = -1;
+        resource.dataSize = -1;
+
+        switch (kind)
+        {
+        case ShaderResourceKind::Uniform:
+        {
+            const GLenum properties[] = { GL_TYPE, GL_LOCATION, GL_BLOCK_INDEX, GL_OFFSET, GL_ARRAY_SIZE, GL_ARRAY_STRIDE, GL_MATRIX_STRIDE };
+            GLint values[7];
+            glGetProgramResourceiv(program, programInterface, i, 7, properties, 7, NULL, values);
+            resource.type = (GLenum)values[0];
+            resource.location = values[1];
+            resource.blockIndex = values[2];
+            resource.offset = values[3];
+            resource.arraySize = values[4];
+            resource.arrayStride = values[5];
+            resource.matrixStride = values[6];
+            break;
+        }
+        case ShaderResourceKind::BufferVariable:
+        {
+            const GLenum properties[] = { GL_TYPE, GL_BLOCK_INDEX, GL_OFFSET, GL_ARRAY_SIZE, GL_ARRAY_STRIDE, GL_MATRIX_STRIDE };
+            GLint values[6];
+            glGetProgramResourceiv(program, programInterface, i, 6, properties, 6, NULL, values);
+            resource.type = (GLenum)values[0];
+            resource.blockIndex = values[1];
+            resource.offset = values[2];
+            resource.arraySize = values[3];
+            resource.arrayStride = values[4];
+            resource.matrixStride = values[5];
+            break;
+        }
+        case ShaderResourceKind::UniformBlock:
+        case ShaderResourceKind::StorageBlock:
+        {
+            const GLenum properties[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+            GLint values[2];
+            glGetProgramResourceiv(program, programInterface, i, 2, properties, 2, NULL, values);
+            resource.blockIndex = i;
+            resource.binding = values[0];
+            resource.dataSize = values[1];
+            break;
+        }
+        case ShaderResourceKind::Attribute:
+        {
+            const GLenum properties[] = { GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE };
+            GLint values[3];
+            glGetProgramResourceiv(program, programInterface, i, 3, properties, 3, NULL, values);
+            resource.type = (GLenum)values[0];
+            resource.location = values[1];
+            resource.arraySize = values[2];
+            break;
+        }
+        }
+
+        // Built-ins like gl_VertexID have no location and nothing to bind. Programs built from SPIR-V may
+        // leave names out altogether; those resources can only be found by location
+        if (strncmp(name.c_str(), "gl_", 3) == 0 || name[0] == '\0') continue;
+        resources.push_back(resource);
+    }
+}
+
+void ReflectShaderProgram(GLuint program)
+{
+    ProgramReflection& reflection = reflections[program];
+    reflection.resources.clear();
+    reflection.slots.clear();
+
+    ReflectInterface(program, GL_UNIFORM, ShaderResourceKind::Uniform, reflection.resources);
+    ReflectInterface(program, GL_UNIFORM_BLOCK, ShaderResourceKind::UniformBlock, reflection.resources);
+    ReflectInterface(program, GL_SHADER_STORAGE_BLOCK, ShaderResourceKind::StorageBlock, reflection.resources);
+    ReflectInterface(program, GL_BUFFER_VARIABLE, ShaderResourceKind::BufferVariable, reflection.resources);
+    ReflectInterface(program, GL_PROGRAM_INPUT, ShaderResourceKind::Attribute, reflection.resources);
+    if (reflection.resources.size() >= EMPTY_SLOT)
+        reflection.resources.resize(EMPTY_SLOT - 1);
+
+    // Keep the table at most half full so probes stay short
+    size_t capacity = 8;
+    while (capacity < reflection.resources.size() * 2) capacity *= 2;
+    reflection.slots.assign(capacity, EMPTY_SLOT);
+    for (size_t i = 0; i < reflection.resources.size(); ++i)
+    {
+        const ShaderResource& resource = reflection.resources[i];
+        size_t slot = SlotHash(resource.kind, resource.nameHash) & (capacity - 1);
+        while (reflection.slots[slot] != EMPTY_SLOT)
+        {
+            const ShaderResource& other = reflection.resources[reflection.slots[slot]];
+            if (other.nameHash == resource.nameHash && other.kind == resource.kind)
+                fprintf(stderr, "Warning: two names in program %u hash to 0x%08x; only the first can be found\n", program, resource.nameHash);
+            slot = (slot + 1) & (capacity - 1);
+        }
+        reflection.slots[slot] = (uint16_t)i;
+    }
+}
+
+void ForgetShaderProgram(GLuint program)
+{
+    reflections.erase(program);
+}
+
+const ProgramReflection* GetProgramReflection(GLuint program)
+{
+    std::unordered_map<GLuint, ProgramReflection>::const_iterator reflection = reflections.find(program);
+    return reflection == reflections.end() ? nullptr : &reflection->second;
+}
+
+const ShaderResource* FindShaderResource(const ProgramReflection* reflection, ShaderResourceKind kind, uint32_t nameHash)
+{
+    if (reflection == nullptr || reflection->slots.empty()) return nullptr;
+
+    size_t mask = reflection->slots.size() - 1;
+    for (size_t slot = SlotHash(kind, nameHash) & mask; reflection->slots[slot] != EMPTY_SLOT; slot = (slot + 1) & mask)
+    {
+        const ShaderResource& resource = reflection->resources[reflection->slots[slot]];
+        if (resource.nameHash == nameHash && resource.kind == kind)
+            return &resource;
+    }
+    return nullptr;
+}
+
+const ShaderResource* FindShaderResource(GLuint program, ShaderResourceKind kind, uint32_t nameHash)
+{
+    return FindShaderResource(GetProgramReflection(program), kind, nameHash);
+}
+
+GLint GetUniformLocation(GLuint program, uint32_t nameHash)
+{
+    const ShaderResource* uniform = FindShaderResource(program, ShaderResourceKind::Uniform, nameHash);
+    return uniform == nullptr ? -1 : uniform->location;
+}
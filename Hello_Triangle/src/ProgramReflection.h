@@ -0,0 +1,64 @@
+#ifndef __ProgramReflection_h__
+#define __ProgramReflection_h__
+
+#include <stdint.h>
+#include <vector>
+#include <GL/glew.h>
+
+// Hash of a resource name, as used to look resources up
+// Written so it can run at compile time: constexpr uint32_t MVP = ShaderNameHash("MVP");
+constexpr uint32_t ShaderNameHash(const char* name, uint32_t hash = 2166136261u)
+{
+    return *name == 0 ? hash : ShaderNameHash(name + 1, (hash ^ (uint32_t)(unsigned char)*name) * 16777619u);
+}
+
+enum class ShaderResourceKind : uint8_t
+{
+    Uniform,        // default block uniforms and uniform block members
+    UniformBlock,
+    StorageBlock,
+    BufferVariable, // shader storage block members
+    Attribute       // vertex shader inputs
+};
+
+// Everything needed to bind a resource, gathered once when the program is linked
+// Fields that do not apply to a kind of resource are -1
+struct ShaderResource
+{
+    uint32_t nameHash;
+    ShaderResourceKind kind;
+    GLenum type;         // e.g. GL_FLOAT_MAT4; 0 for blocks
+    GLint location;      // uniforms outside blocks, and attributes
+    GLint blockIndex;    // the block a member lives in, or a block's own index
+    GLint offset;        // byte offset of a block member
+    GLint arraySize;
+    GLint arrayStride;   // block members
+    GLint matrixStride;  // block members
+    GLint binding;       // blocks
+    GLint dataSize;      // blocks, in bytes
+};
+
+struct ProgramReflection
+{
+    std::vector<ShaderResource> resources;
+    // Open addressing table of indices into resources; its size is a power of two
+    std::vector<uint16_t> slots;
+};
+
+// Build the reflection table for a linked program, replacing any previous one for the same handle
+// Every program built by ShaderLoader is reflected automatically. Resources without a name, which programs
+// built from SPIR-V may have, are left out: use the locations the shaders declare for those
+void ReflectShaderProgram(GLuint program);
+// Drop the reflection table of a program that is being deleted
+void ForgetShaderProgram(GLuint program);
+// The reflection table of a program, or nullptr if it has none
+// The pointer stays valid until the program is forgotten or reflected again
+const ProgramReflection* GetProgramReflection(GLuint program);
+
+// Find a resource by name hash, or nullptr if the program does not use it
+const ShaderResource* FindShaderResource(const ProgramReflection* reflection, ShaderResourceKind kind, uint32_t nameHash);
+const ShaderResource* FindShaderResource(GLuint program, ShaderResourceKind kind, uint32_t nameHash);
+// Location of a uniform outside any block, or -1, the same as glGetUniformLocation would give
+GLint GetUniformLocation(GLuint program, uint32_t nameHash);
+
+#endif
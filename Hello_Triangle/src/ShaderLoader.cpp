@@ -1,17 +1,32 @@
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "Data.h"
 #include "ErrorHandling.h"
+#include "ProgramPipeline.h"
+#include "ProgramReflection.h"
 #include "ShaderLoader.h"
+#include "ShaderPreprocessor.h"
 
-GLuint CompileShader(const char* shaderSource, GLuint shaderType)
+static void CheckShaderCompiled(GLuint shaderId);
+static void CheckProgramLinked(GLuint ProgramId);
+
+// Compile source that has already been through PreprocessShaderSource
+static GLuint CompilePreprocessedShader(const char* shaderSource, GLuint shaderType)
 {
     err_checkGL("Before compiling shader");
 
-    if (shaderSource[0] == 0) return 0;
     GLuint shaderId = glCreateShader(shaderType);
     glShaderSource(shaderId, 1, &shaderSource, NULL);
     glCompileShader(shaderId);
+    CheckShaderCompiled(shaderId);
 
+    return shaderId;
+}
+
+// Report how compiling went; a failure is fatal
+static void CheckShaderCompiled(GLuint shaderId)
+{
     GLint Result = GL_FALSE;
     int InfoLogLength;
 
@@ -22,54 +37,132 @@ GLuint CompileShader(const char* shaderSource, GLuint shaderType)
     if (Result == GL_TRUE) // compiler warnings
         fprintf(stdout, "%s\n", &InfoLog[0]);
     else // compiler errors
-        err_fatalf("%s\n", &InfoLog[0]);
+        err_fatalf("%s\n%s", &InfoLog[0], ShaderSourceLegend().c_str());
 
     err_checkGL("Compiling shader");
+}
 
-    return shaderId;
+GLuint CompileShader(const char* shaderSource, GLuint shaderType)
+{
+    if (shaderSource[0] == 0) return 0;
+    std::string preprocessed = PreprocessShaderSource(shaderSource, tryLoadFile);
+    return CompilePreprocessedShader(preprocessed.c_str(), shaderType);
 }
 
-GLuint LoadFragmentShaderFile(const char* filePath)
+// Compiled shader objects shared between programs, by stage and preprocessed source
+struct CachedShader
+{
+    GLuint shader;
+    uint64_t key;
+    size_t sourceLength; // a cheap guard against hash collisions
+    int references;
+};
+static std::unordered_map<uint64_t, CachedShader> shaderCache;
+static std::unordered_map<GLuint, uint64_t> cachedShaderKeys;
+// The cached shaders each program holds a reference to
+static std::unordered_map<GLuint, std::vector<GLuint>> programShaders;
+static ShaderCacheStats shaderCacheStats;
+
+// Get a compiled shader for this source, compiling it only if no program already has it
+// When wait is false the compile is started but not checked, as BeginShaderProgramSource needs.
+// An empty source is compiled like any other, so it fails where a broken one would rather than attaching 0
+static GLuint AcquireShader(const char* source, GLuint shaderType, const std::vector<std::string>& defines, bool wait)
+{
+    std::string preprocessed = PreprocessShaderSource(source, tryLoadFile, defines);
+    uint64_t key = HashShaderText(preprocessed, (int)shaderType);
+
+    std::unordered_map<uint64_t, CachedShader>::iterator cached = shaderCache.find(key);
+    if (cached != shaderCache.end() && cached->second.sourceLength == preprocessed.size())
+    {
+        ++cached->second.references;
+        ++shaderCacheStats.compilesAvoided;
+        return cached->second.shader;
+    }
+
+    GLuint shader;
+    if (wait)
+    {
+        shader = CompilePreprocessedShader(preprocessed.c_str(), shaderType);
+    }
+    else
+    {
+        const char* preprocessedSource = preprocessed.c_str();
+        shader = glCreateShader(shaderType);
+        glShaderSource(shader, 1, &preprocessedSource, NULL);
+        glCompileShader(shader);
+    }
+    ++shaderCacheStats.compiles;
+
+    // On a collision the newcomer simply isn't shared
+    if (cached == shaderCache.end())
+    {
+        CachedShader entry = { shader, key, preprocessed.size(), 1 };
+        shaderCache.emplace(key, entry);
+        cachedShaderKeys.emplace(shader, key);
+    }
+    return shader;
+}
+
+static void ReleaseShader(GLuint shader)
+{
+    std::unordered_map<GLuint, uint64_t>::iterator key = cachedShaderKeys.find(shader);
+    if (key != cachedShaderKeys.end())
+    {
+        CachedShader& cached = shaderCache[key->second];
+        if (--cached.references > 0) return;
+        shaderCache.erase(key->second);
+        cachedShaderKeys.erase(key);
+    }
+    glDeleteShader(shader);
+}
+
+static void ReleaseProgramShaders(GLuint program)
+{
+    std::unordered_map<GLuint, std::vector<GLuint>>::iterator shaders = programShaders.find(program);
+    if (shaders == programShaders.end()) return;
+    for (GLuint shader : shaders->second)
+        ReleaseShader(shader);
+    programShaders.erase(shaders);
+}
+
+ShaderCacheStats GetShaderCacheStats()
+{
+    ShaderCacheStats stats = shaderCacheStats;
+    stats.liveShaders = (unsigned)shaderCache.size();
+    return stats;
+}
+
+Shader LoadFragmentShaderFile(const char* filePath)
 {
     std::string fileContents = loadFile(filePath);
     return LoadFragmentShaderSource(fileContents.c_str());
 }
 
-GLuint LoadFragmentShaderSource(const char* source)
+Shader LoadFragmentShaderSource(const char* source)
 {
-    return CompileShader(source, GL_FRAGMENT_SHADER);
+    return Shader(CompileShader(source, GL_FRAGMENT_SHADER));
 }
 
-GLuint LoadVertexShaderFile(const char* filePath)
+Shader LoadVertexShaderFile(const char* filePath)
 {
     std::string fileContents = loadFile(filePath);
     return LoadVertexShaderSource(fileContents.c_str());
 }
 
-GLuint LoadVertexShaderSource(const char* source)
+Shader LoadVertexShaderSource(const char* source)
 {
-    return CompileShader(source, GL_VERTEX_SHADER);
+    return Shader(CompileShader(source, GL_VERTEX_SHADER));
 }
 
-GLuint LoadShaderProgramFile(const char* fragmentFilePath, const char* vertexFilePath)
+Program LoadShaderProgramFile(const char* fragmentFilePath, const char* vertexFilePath)
 {
     std::string fragmentFileContents = loadFile(fragmentFilePath);
     std::string vertexFileContents = loadFile(vertexFilePath);
     return LoadShaderProgramSource(fragmentFileContents.c_str(), vertexFileContents.c_str());
 }
 
-GLuint LoadShaderProgramSource(const char* fragmentSource, const char* vertexSource)
-{
-    GLuint fragmentShader = LoadFragmentShaderSource(fragmentSource);
-    GLuint vertexShader = LoadVertexShaderSource(vertexSource);
-    GLuint program = LoadShaderProgram(fragmentShader, vertexShader);
-    glDeleteShader(fragmentShader);
-    glDeleteShader(vertexShader);
-    err_checkGL("Marking shader for deletion");
-    return program;
-}
-
-GLuint LoadShaderProgram(GLuint fragmentShader, GLuint vertexShader)
+// Link a program from shaders owned by someone else
+static GLuint LinkShaderProgram(GLuint fragmentShader, GLuint vertexShader)
 {
     err_checkGL("Before linking shader program");
 
@@ -77,7 +170,105 @@ GLuint LoadShaderProgram(GLuint fragmentShader, GLuint vertexShader)
     glAttachShader(ProgramId, fragmentShader);
     glAttachShader(ProgramId, vertexShader);
     glLinkProgram(ProgramId);
+    CheckProgramLinked(ProgramId);
+
+    return ProgramId;
+}
+
+Program LoadShaderProgramSource(const char* fragmentSource, const char* vertexSource)
+{
+    // The shaders come from the cache and stay there, attached, until the program is deleted
+    GLuint fragmentShader = AcquireShader(fragmentSource, GL_FRAGMENT_SHADER, std::vector<std::string>(), true);
+    GLuint vertexShader = AcquireShader(vertexSource, GL_VERTEX_SHADER, std::vector<std::string>(), true);
+    GLuint program = LinkShaderProgram(fragmentShader, vertexShader);
+    programShaders[program] = { fragmentShader, vertexShader };
+    return Program(program);
+}
+
+Program LoadShaderProgram(const Shader& fragmentShader, const Shader& vertexShader)
+{
+    return Program(LinkShaderProgram(fragmentShader.get(), vertexShader.get()));
+}
+
+Program LoadSeparableShaderProgramFile(const char* filePath, GLenum shaderType)
+{
+    std::string fileContents = loadFile(filePath);
+    return LoadSeparableShaderProgramSource(fileContents.c_str(), shaderType);
+}
+
+Program LoadSeparableShaderProgramSource(const char* source, GLenum shaderType)
+{
+    GLuint shader = AcquireShader(source, shaderType, std::vector<std::string>(), true);
+
+    err_checkGL("Before linking separable shader program");
 
+    GLuint ProgramId = glCreateProgram();
+    glProgramParameteri(ProgramId, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    glAttachShader(ProgramId, shader);
+    glLinkProgram(ProgramId);
+    programShaders[ProgramId] = { shader };
+    CheckProgramLinked(ProgramId);
+
+    return Program(ProgramId);
+}
+
+bool IsSpirvSupported()
+{
+    return GLEW_VERSION_4_6 || GLEW_ARB_gl_spirv;
+}
+
+// Load a SPIR-V module and specialize its main entry point
+static Shader LoadSpirvShader(const std::string& binary, GLuint shaderType, const std::vector<ShaderSpecialization>& specializations)
+{
+    err_checkGL("Before loading SPIR-V shader");
+
+    std::vector<GLuint> constantIds, constantValues;
+    for (const ShaderSpecialization& specialization : specializations)
+    {
+        constantIds.push_back(specialization.constantId);
+        constantValues.push_back(specialization.value);
+    }
+
+    GLuint shaderId = glCreateShader(shaderType);
+    glShaderBinary(1, &shaderId, GL_SHADER_BINARY_FORMAT_SPIR_V, binary.data(), (GLsizei)binary.size());
+    if (GLEW_VERSION_4_6)
+        glSpecializeShader(shaderId, "main", (GLuint)constantIds.size(), constantIds.data(), constantValues.data());
+    else
+        glSpecializeShaderARB(shaderId, "main", (GLuint)constantIds.size(), constantIds.data(), constantValues.data());
+    CheckShaderCompiled(shaderId);
+
+    return Shader(shaderId);
+}
+
+Program LoadShaderProgramSpirvFile(const char* fragmentFilePath, const char* vertexFilePath, const std::vector<ShaderSpecialization>& specializations)
+{
+    std::string fragmentBinary, vertexBinary;
+    if (IsSpirvSupported()
+        && tryLoadFile((std::string(fragmentFilePath) + ".spv").c_str(), fragmentBinary)
+        && tryLoadFile((std::string(vertexFilePath) + ".spv").c_str(), vertexBinary))
+    {
+        // The shaders are only marked for deletion on return; the program keeps them alive
+        Shader fragmentShader = LoadSpirvShader(fragmentBinary, GL_FRAGMENT_SHADER, specializations);
+        Shader vertexShader = LoadSpirvShader(vertexBinary, GL_VERTEX_SHADER, specializations);
+        return LoadShaderProgram(fragmentShader, vertexShader);
+    }
+
+    // No SPIR-V: compile the GLSL instead, with the constants as #defines
+    std::vector<std::string> defines;
+    for (const ShaderSpecialization& specialization : specializations)
+        defines.push_back(std::string(specialization.define) + " " + std::to_string(specialization.value));
+    std::string fragmentSource = loadFile(fragmentFilePath);
+    std::string vertexSource = loadFile(vertexFilePath);
+    GLuint fragmentShader = AcquireShader(fragmentSource.c_str(), GL_FRAGMENT_SHADER, defines, true);
+    GLuint vertexShader = AcquireShader(vertexSource.c_str(), GL_VERTEX_SHADER, defines, true);
+    GLuint program = LinkShaderProgram(fragmentShader, vertexShader);
+    programShaders[program] = { fragmentShader, vertexShader };
+    return Program(program);
+}
+
+// Report how linking went; a failure is fatal
+static void CheckProgramLinked(GLuint ProgramId)
+{
     GLint Result = GL_FALSE;
     int InfoLogLength;
 
@@ -92,5 +283,79 @@ GLuint LoadShaderProgram(GLuint fragmentShader, GLuint vertexShader)
 
     err_checkGL("Linking shader program");
 
-    return ProgramId;
+    ReflectShaderProgram(ProgramId);
+    err_checkGL("Reflecting shader program");
+}
+
+Program BeginShaderProgramSource(const char* fragmentSource, const char* vertexSource, const std::vector<std::string>& defines)
+{
+    err_checkGL("Before building shader program");
+
+    GLuint fragmentShader = AcquireShader(fragmentSource, GL_FRAGMENT_SHADER, defines, false);
+    GLuint vertexShader = AcquireShader(vertexSource, GL_VERTEX_SHADER, defines, false);
+
+    // Linking straight away lets the driver carry on without us checking each shader first;
+    // a shader that failed to compile makes the link fail too
+    GLuint ProgramId = glCreateProgram();
+    glAttachShader(ProgramId, fragmentShader);
+    glAttachShader(ProgramId, vertexShader);
+    glLinkProgram(ProgramId);
+    programShaders[ProgramId] = { fragmentShader, vertexShader };
+
+    err_checkGL("Building shader program");
+
+    return Program(ProgramId);
+}
+
+bool IsShaderProgramReady(GLuint program)
+{
+    if (!GLEW_ARB_parallel_shader_compile) return true;
+
+    GLint Result = GL_TRUE;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_ARB, &Result);
+    return Result == GL_TRUE;
+}
+
+bool FinishShaderProgram(Program& programObject)
+{
+    GLuint program = programObject.get();
+    GLint Result = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &Result);
+    if (Result == GL_TRUE)
+    {
+        ReflectShaderProgram(program);
+        err_checkGL("Reflecting shader program");
+        return true;
+    }
+
+    // The shaders are still attached, so their compile logs are still around
+    GLuint shaders[2];
+    GLsizei shaderCount = 0;
+    glGetAttachedShaders(program, 2, &shaderCount, shaders);
+    for (GLsizei i = 0; i < shaderCount; ++i)
+    {
+        int InfoLogLength;
+        glGetShaderiv(shaders[i], GL_INFO_LOG_LENGTH, &InfoLogLength);
+        std::string InfoLog(InfoLogLength <= 0 ? 1 : InfoLogLength, '\0');
+        glGetShaderInfoLog(shaders[i], InfoLogLength, NULL, &InfoLog[0]);
+        fprintf(stderr, "%s\n", &InfoLog[0]);
+    }
+
+    int InfoLogLength;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &InfoLogLength);
+    std::string InfoLog(InfoLogLength <= 0 ? 1 : InfoLogLength, '\0');
+    glGetProgramInfoLog(program, InfoLogLength, NULL, &InfoLog[0]);
+    fprintf(stderr, "%s\n%s", &InfoLog[0], ShaderSourceLegend().c_str());
+
+    programObject.reset();
+    err_checkGL("Discarding shader program");
+    return false;
+}
+
+void DeleteShaderProgram(GLuint program)
+{
+    ForgetShaderProgram(program);
+    ForgetProgramPipelines(program);
+    glDeleteProgram(program);
+    ReleaseProgramShaders(program);
 }
@@ -3,25 +3,83 @@
 
 #include <GL/glew.h>
 #include <GL/GL.h>
+#include <string>
+#include <vector>
+#include "GLObjects.h"
+#include "ShaderPreprocessor.h"
+
+// Every shader compiled from GLSL below is run through PreprocessShaderSource first
+// Shaders and programs are returned as owning handles (see GLObjects.h); move them to keep them
 
 // Load a fragment shader from a file
-GLuint LoadFragmentShaderFile(const char* filePath);
+Shader LoadFragmentShaderFile(const char* filePath);
 // Load a fragment shader from source
-GLuint LoadFragmentShaderSource(const char* source);
+Shader LoadFragmentShaderSource(const char* source);
 
 // Load a vertex shader from a file
-GLuint LoadVertexShaderFile(const char* filePath);
+Shader LoadVertexShaderFile(const char* filePath);
 // Load a vertex shader from source
-GLuint LoadVertexShaderSource(const char* source);
+Shader LoadVertexShaderSource(const char* source);
 
 // Load a shader program from the source files of its component shaders
-// Shaders will be deleted by OpenGL upon deletion of the returned shader program
-GLuint LoadShaderProgramFile(const char* fragmentFilePath, const char* vertexFilePath);
+// Shaders are shared with any other program built from the same source, and are deleted
+// when the last program using them is deleted
+Program LoadShaderProgramFile(const char* fragmentFilePath, const char* vertexFilePath);
 // Load a shader program from the source of its component shaders
-// Shaders will be deleted by OpenGL upon deletion of the returned shader program
-GLuint LoadShaderProgramSource(const char* fragmentSource, const char* vertexSource);
+// Shaders are shared the same way as LoadShaderProgramFile
+Program LoadShaderProgramSource(const char* fragmentSource, const char* vertexSource);
 // Load a shader program from the its component shaders
-// Users are expected to handle their own shader deletion logic
-GLuint LoadShaderProgram(GLuint fragmentShader, GLuint vertexShader);
+// The shaders stay with the caller, who may delete them as soon as this returns
+Program LoadShaderProgram(const Shader& fragmentShader, const Shader& vertexShader);
+
+// Load a program holding a single stage, linked with GL_PROGRAM_SEPARABLE so it can be mixed with
+// other stages at draw time through GetProgramPipeline instead of linking every combination
+// Vertex shaders must redeclare the built-in outputs they write, e.g. out gl_PerVertex { vec4 gl_Position; };
+Program LoadSeparableShaderProgramFile(const char* filePath, GLenum shaderType);
+Program LoadSeparableShaderProgramSource(const char* source, GLenum shaderType);
+
+// Whether the driver accepts SPIR-V shaders (OpenGL 4.6 or GL_ARB_gl_spirv)
+bool IsSpirvSupported();
+// A value for a SPIR-V specialization constant. Integer and boolean constants only
+struct ShaderSpecialization
+{
+    GLuint constantId;  // as in layout(constant_id = N)
+    GLuint value;
+    const char* define; // what the GLSL fallback #defines to value instead
+};
+// Load a shader program from the SPIR-V modules built offline from its GLSL files (the same paths with
+// ".spv" added, packed with the shaders and found by name regardless of case), skipping the driver's GLSL compiler. Falls back to compiling the GLSL files when SPIR-V
+// is not supported or not built. Shaders written for both guard their constants with GL_SPIRV:
+//   #ifdef GL_SPIRV
+//   layout(constant_id = 0) const int LIGHT_COUNT = 1;
+//   #endif
+Program LoadShaderProgramSpirvFile(const char* fragmentFilePath, const char* vertexFilePath,
+    const std::vector<ShaderSpecialization>& specializations = std::vector<ShaderSpecialization>());
+
+// Start building a shader program without waiting on the driver to compile or link it
+// Unlike the functions above, a broken shader is not fatal; check the result with FinishShaderProgram
+// defines are added to both shaders, as with PreprocessShaderSource
+Program BeginShaderProgramSource(const char* fragmentSource, const char* vertexSource,
+    const std::vector<std::string>& defines = std::vector<std::string>());
+// Whether the driver has finished building a program from BeginShaderProgramSource
+// Always true unless the driver compiles in the background (GL_ARB_parallel_shader_compile)
+bool IsShaderProgramReady(GLuint program);
+// Check how a program from BeginShaderProgramSource turned out
+// On failure the logs are printed, the program is deleted (program is left empty) and false is returned
+bool FinishShaderProgram(Program& program);
+
+// Delete a program built by any of the above, along with its reflection table (see ProgramReflection.h)
+// and its references to shared shaders
+// Program does this itself; only call it for names taken out of a Program with release()
+void DeleteShaderProgram(GLuint program);
+
+struct ShaderCacheStats
+{
+    unsigned compiles;        // shaders actually handed to the compiler
+    unsigned compilesAvoided; // shaders reused from another program instead
+    unsigned liveShaders;     // shaders currently held by the cache
+};
+// How well programs are sharing their shaders
+ShaderCacheStats GetShaderCacheStats();
 
 #endif
@@ -0,0 +1,225 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ShaderPreprocessor.h"
+
+// Files pulled in with #include, by lower-cased path, so each one is only read once
+struct ShaderInclude
+{
+    int sourceNumber;
+    uint64_t hash;
+    std::string contents;
+};
+static std::unordered_map<std::string, ShaderInclude> shaderIncludes;
+// Where includes that changed since startup are on disk, by lower-cased path
+static std::unordered_map<std::string, std::string> changedIncludes;
+// Fully expanded includes, by content hash, so each one is only scanned once
+static std::unordered_map<uint64_t, std::string> expandedIncludes;
+// Source string numbers used in #line directives; 0 is the shader itself
+static std::unordered_map<std::string, int> sourceNumbers;
+static std::vector<std::string> sourceNames(1);
+
+static const int MAX_INCLUDE_DEPTH = 32;
+
+static std::string LowerCase(const std::string& text)
+{
+    std::string lower = text;
+    for (char& c : lower)
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+    return lower;
+}
+
+uint64_t HashShaderText(const std::string& text, int salt)
+{
+    uint64_t hash = 14695981039346656037ull ^ (uint64_t)salt;
+    for (char c : text)
+    {
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string ShaderSourceLegend()
+{
+    std::string legend;
+    for (size_t i = 1; i < sourceNames.size(); ++i)
+        legend += "Source string " + std::to_string(i) + " is " + sourceNames[i] + "\n";
+    return legend;
+}
+
+// Match a preprocessor directive at the start of a line, returning where its arguments start
+static const char* MatchDirective(const char* line, const char* lineEnd, const char* directive)
+{
+    while (line < lineEnd && (*line == ' ' || *line == '\t')) ++line;
+    if (line == lineEnd || *line != '#') return nullptr;
+    ++line;
+    while (line < lineEnd && (*line == ' ' || *line == '\t')) ++line;
+    size_t length = strlen(directive);
+    if ((size_t)(lineEnd - line) < length || strncmp(line, directive, length) != 0) return nullptr;
+    return line + length;
+}
+
+static const std::string& ExpandShaderInclude(const std::string& path, int depth);
+
+// Read an edited include straight from the file system, where the loader would find the packed copy first
+static bool ReadChangedFile(const std::string& filePath, std::string& contents)
+{
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (file == nullptr) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    contents.resize(size > 0 ? (size_t)size : 0);
+    bool ok = size >= 0 && fread(&contents[0], 1, contents.size(), file) == contents.size();
+    fclose(file);
+    return ok;
+}
+
+// Problems found while expanding; they are also left in the output as #error lines
+static std::string* expansionErrors = nullptr;
+// How the current expansion reads include files
+static ShaderFileLoader includeLoader = nullptr;
+
+static void AddError(std::string& output, const std::string& message)
+{
+    output += "#error " + message + "\n";
+    if (expansionErrors != nullptr)
+        *expansionErrors += message + "\n";
+}
+
+static void ExpandShaderText(const std::string& text, int sourceNumber, const std::string& directory, int depth,
+    const std::vector<std::string>* defines, std::string& output)
+{
+    bool definesInjected = defines == nullptr || defines->empty();
+    int lineNumber = 1;
+    for (size_t lineStart = 0; lineStart < text.size(); ++lineNumber)
+    {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string::npos) lineEnd = text.size();
+        const char* line = text.c_str() + lineStart;
+        const char* end = text.c_str() + lineEnd;
+
+        const char* arguments = MatchDirective(line, end, "include");
+        if (arguments != nullptr)
+        {
+            while (arguments < end && (*arguments == ' ' || *arguments == '\t')) ++arguments;
+            const char* nameEnd = arguments < end ? (const char*)memchr(arguments + 1, *arguments == '<' ? '>' : '"', end - arguments - 1) : nullptr;
+            if (nameEnd == nullptr || (*arguments != '"' && *arguments != '<'))
+            {
+                AddError(output, "malformed #include");
+            }
+            else if (depth >= MAX_INCLUDE_DEPTH)
+            {
+                AddError(output, "#include nested too deeply; is a file including itself?");
+            }
+            else
+            {
+                std::string includePath = directory + std::string(arguments + 1, nameEnd);
+                const std::string& expanded = ExpandShaderInclude(includePath, depth + 1);
+                if (expanded.empty() && shaderIncludes.find(LowerCase(includePath)) == shaderIncludes.end())
+                {
+                    AddError(output, "unable to open \"" + includePath + "\"");
+                }
+                else
+                {
+                    output += "#line 1 " + std::to_string(sourceNumbers[LowerCase(includePath)]) + "\n";
+                    output += expanded;
+                    if (!expanded.empty() && expanded.back() != '\n') output += '\n';
+                    output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceNumber) + "\n";
+                }
+            }
+        }
+        else
+        {
+            output.append(line, end);
+            output += '\n';
+            // Defines have to come after #version, which has to come before everything else
+            if (!definesInjected && MatchDirective(line, end, "version") != nullptr)
+            {
+                for (const std::string& define : *defines)
+                    output += "#define " + define + "\n";
+                output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceNumber) + "\n";
+                definesInjected = true;
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+
+    if (!definesInjected)
+    {
+        std::string prefix;
+        for (const std::string& define : *defines)
+            prefix += "#define " + define + "\n";
+        prefix += "#line 1 " + std::to_string(sourceNumber) + "\n";
+        output.insert(0, prefix);
+    }
+}
+
+// Expand an include file, returning an empty string if it could not be read
+static const std::string& ExpandShaderInclude(const std::string& path, int depth)
+{
+    static const std::string missing;
+
+    std::string key = LowerCase(path);
+    std::unordered_map<std::string, ShaderInclude>::iterator include = shaderIncludes.find(key);
+    if (include == shaderIncludes.end())
+    {
+        ShaderInclude newInclude;
+        // Missing files are not remembered, so they are picked up once they exist
+        std::unordered_map<std::string, std::string>::const_iterator changed = changedIncludes.find(key);
+        bool loaded = changed != changedIncludes.end() ? ReadChangedFile(changed->second, newInclude.contents)
+            : includeLoader(path.c_str(), newInclude.contents);
+        if (!loaded) return missing;
+
+        // Numbers stay the same when a file is reloaded, so the legend stays valid
+        std::unordered_map<std::string, int>::iterator number = sourceNumbers.find(key);
+        if (number == sourceNumbers.end())
+        {
+            number = sourceNumbers.emplace(key, (int)sourceNames.size()).first;
+            sourceNames.push_back(path);
+        }
+        newInclude.sourceNumber = number->second;
+        newInclude.hash = HashShaderText(newInclude.contents, newInclude.sourceNumber);
+        include = shaderIncludes.emplace(key, std::move(newInclude)).first;
+    }
+
+    std::unordered_map<uint64_t, std::string>::iterator expanded = expandedIncludes.find(include->second.hash);
+    if (expanded == expandedIncludes.end())
+    {
+        std::string text;
+        size_t slash = path.find_last_of("/\\");
+        std::string directory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+        ExpandShaderText(include->second.contents, include->second.sourceNumber, directory, depth, nullptr, text);
+        expanded = expandedIncludes.emplace(include->second.hash, std::move(text)).first;
+    }
+    return expanded->second;
+}
+
+std::string PreprocessShaderSource(const char* source, ShaderFileLoader loadFile, const std::vector<std::string>& defines, std::string* errors)
+{
+    // Cooked shaders have nothing left to expand
+    if (defines.empty() && strstr(source, "#include") == nullptr)
+        return source;
+
+    std::string output;
+    expansionErrors = errors;
+    includeLoader = loadFile;
+    ExpandShaderText(source, 0, "", 0, &defines, output);
+    expansionErrors = nullptr;
+    includeLoader = nullptr;
+    return output;
+}
+
+bool InvalidateShaderInclude(const char* filePath, const char* changedFilePath)
+{
+    // Remembered even if it has not been included yet, so the first include already gets the edit
+    changedIncludes[LowerCase(filePath)] = changedFilePath;
+    if (shaderIncludes.erase(LowerCase(filePath)) == 0) return false;
+    // Anything that included it has the old contents baked in
+    expandedIncludes.clear();
+    return true;
+}
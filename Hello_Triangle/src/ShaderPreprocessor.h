@@ -0,0 +1,27 @@
+#ifndef __ShaderPreprocessor_h__
+#define __ShaderPreprocessor_h__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Reads a file the preprocessor needs, such as tryLoadFile; returns false if it is missing
+typedef bool (*ShaderFileLoader)(const char* filePath, std::string& contents);
+
+// Expand #include "file" directives and add the given #defines (e.g. "MAX_LIGHTS 4") just after #version
+// Included paths are relative to the including file, starting from the data directory, and read with loadFile
+// #line directives keep compiler messages pointing at the right line, with each included file
+// numbered as its own source string. Problems are left in the output as #error lines, and also
+// appended to errors when it is given
+std::string PreprocessShaderSource(const char* source, ShaderFileLoader loadFile,
+    const std::vector<std::string>& defines = std::vector<std::string>(), std::string* errors = nullptr);
+// Drop a cached include file after it has changed on disk, and read it from changedFilePath, the edited
+// file itself, from then on; the packed archive still holds the old contents
+// Returns false if it had never been included
+bool InvalidateShaderInclude(const char* filePath, const char* changedFilePath);
+// Which file each source string number refers to, to go with compiler messages
+std::string ShaderSourceLegend();
+// 64-bit FNV-1a of some shader text, salted so the same text can be told apart by use
+uint64_t HashShaderText(const std::string& text, int salt);
+
+#endif
@@ -0,0 +1,227 @@
+#include <memory>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#include <sys/stat.h>
+#endif
+#include "AsyncLoader.h"
+#include "Data.h"
+#include "ShaderLoader.h"
+#include "ShaderReloader.h"
+
+struct WatchedProgram
+{
+    Program* program;
+    std::string fragmentFile; // relative to the watched directory
+    std::string vertexFile;
+    bool dirty = false;
+
+    // A rebuild goes: read both files, then build, then swap
+    int sourcesPending = 0;
+    std::string fragmentSource;
+    std::string vertexSource;
+    Program building;
+
+#ifndef __linux__
+    time_t fragmentWriteTime = 0;
+    time_t vertexWriteTime = 0;
+#endif
+};
+
+static std::vector<std::unique_ptr<WatchedProgram>> watched;
+#ifdef __linux__
+static int inotifyFd = -1;
+#endif
+
+// Shaders are edited in the source tree, not the copy next to the executable, so watch that when the build tells us where it is
+static const std::string& WatchDirectory()
+{
+#ifdef DATA_SOURCE_DIR
+    static const std::string directory = DATA_SOURCE_DIR;
+#else
+    static const std::string directory = DataPathToFilePath("");
+#endif
+    return directory;
+}
+
+static bool EqualsIgnoreCase(const std::string& a, const char* b)
+{
+    size_t i = 0;
+    for (; i < a.size() && b[i]; ++i)
+    {
+        char x = a[i], y = b[i];
+        if (x >= 'A' && x <= 'Z') x += 'a' - 'A';
+        if (y >= 'A' && y <= 'Z') y += 'a' - 'A';
+        if (x != y) return false;
+    }
+    return i == a.size() && b[i] == 0;
+}
+
+static void MarkChanged(const char* fileName)
+{
+    // A changed include could be used by anything; it is read back from here, not the packed archive
+    bool isInclude = InvalidateShaderInclude(fileName, (WatchDirectory() + fileName).c_str());
+    for (std::unique_ptr<WatchedProgram>& program : watched)
+    {
+        if (isInclude)
+            program->dirty = true;
+        // Asset names are case-insensitive, so remember the name the file actually has
+        if (EqualsIgnoreCase(program->fragmentFile, fileName))
+        {
+            program->fragmentFile = fileName;
+            program->dirty = true;
+        }
+        if (EqualsIgnoreCase(program->vertexFile, fileName))
+        {
+            program->vertexFile = fileName;
+            program->dirty = true;
+        }
+    }
+}
+
+#ifdef __linux__
+// Find the real name of a file whose name only matches case-insensitively
+static std::string ResolveFileName(const char* fileName)
+{
+    std::string resolved = fileName;
+    DIR* directory = opendir(WatchDirectory().c_str());
+    if (directory == nullptr) return resolved;
+    while (dirent* entry = readdir(directory))
+    {
+        if (EqualsIgnoreCase(resolved, entry->d_name))
+        {
+            resolved = entry->d_name;
+            break;
+        }
+    }
+    closedir(directory);
+    return resolved;
+}
+
+static void CollectChanges()
+{
+    if (inotifyFd < 0) return;
+
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) break; // nothing more until the next frame
+        for (char* ptr = buffer; ptr < buffer + length;)
+        {
+            const inotify_event* event = (const inotify_event*)ptr;
+            if (event->len > 0)
+                MarkChanged(event->name);
+            ptr += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+#else
+static time_t LastWriteTime(const std::string& fileName)
+{
+    struct stat fileStat;
+    if (stat((WatchDirectory() + fileName).c_str(), &fileStat) != 0) return 0;
+    return fileStat.st_mtime;
+}
+
+static void CollectChanges()
+{
+    // Without change notifications, poll the files a couple of times a second
+    static std::chrono::steady_clock::time_point lastPoll;
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now - lastPoll < std::chrono::milliseconds(500)) return;
+    lastPoll = now;
+
+    for (std::unique_ptr<WatchedProgram>& program : watched)
+    {
+        time_t fragmentWriteTime = LastWriteTime(program->fragmentFile);
+        time_t vertexWriteTime = LastWriteTime(program->vertexFile);
+        if (fragmentWriteTime != program->fragmentWriteTime || vertexWriteTime != program->vertexWriteTime)
+            program->dirty = true;
+        program->fragmentWriteTime = fragmentWriteTime;
+        program->vertexWriteTime = vertexWriteTime;
+    }
+}
+#endif
+
+void WatchShaderProgram(Program* programObject, const char* fragmentFilePath, const char* vertexFilePath)
+{
+    std::unique_ptr<WatchedProgram> program(new WatchedProgram());
+    program->program = programObject;
+#ifdef __linux__
+    if (inotifyFd < 0)
+    {
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        // Editors either rewrite a file in place or write a new one and rename it over the old
+        if (inotifyFd >= 0 && inotify_add_watch(inotifyFd, WatchDirectory().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+            close(inotifyFd);
+            inotifyFd = -1;
+        }
+        if (inotifyFd < 0)
+            fprintf(stderr, "Unable to watch %s; shaders will not be reloaded\n", WatchDirectory().c_str());
+    }
+    program->fragmentFile = ResolveFileName(fragmentFilePath);
+    program->vertexFile = ResolveFileName(vertexFilePath);
+#else
+    program->fragmentFile = fragmentFilePath;
+    program->vertexFile = vertexFilePath;
+    program->fragmentWriteTime = LastWriteTime(program->fragmentFile);
+    program->vertexWriteTime = LastWriteTime(program->vertexFile);
+#endif
+    watched.push_back(std::move(program));
+}
+
+bool UpdateShaderReloads()
+{
+    CollectChanges();
+
+    bool swapped = false;
+    for (std::unique_ptr<WatchedProgram>& watchedProgram : watched)
+    {
+        WatchedProgram* program = watchedProgram.get();
+
+        // Only one rebuild at a time; changes made during a rebuild start another one after it
+        if (program->dirty && program->sourcesPending == 0 && !program->building)
+        {
+            program->dirty = false;
+            program->sourcesPending = 2;
+            // Both callbacks run from pumpAsyncLoads, on this thread, so the last one in can start the build
+            auto sourceLoaded = [program](std::string& source, std::string&& contents) {
+                source = std::move(contents);
+                if (--program->sourcesPending == 0)
+                {
+                    program->building = BeginShaderProgramSource(program->fragmentSource.c_str(), program->vertexSource.c_str());
+                    program->fragmentSource.clear();
+                    program->vertexSource.clear();
+                }
+            };
+            loadFileAsync((WatchDirectory() + program->fragmentFile).c_str(),
+                [program, sourceLoaded](std::string&& contents) { sourceLoaded(program->fragmentSource, std::move(contents)); });
+            loadFileAsync((WatchDirectory() + program->vertexFile).c_str(),
+                [program, sourceLoaded](std::string&& contents) { sourceLoaded(program->vertexSource, std::move(contents)); });
+        }
+
+        if (program->building && IsShaderProgramReady(program->building.get()))
+        {
+            if (FinishShaderProgram(program->building))
+            {
+                // Moving over the old program deletes it
+                *program->program = std::move(program->building);
+                swapped = true;
+                fprintf(stdout, "Reloaded %s and %s\n", program->fragmentFile.c_str(), program->vertexFile.c_str());
+            }
+            else
+            {
+                fprintf(stderr, "Keeping the previous build of %s and %s\n", program->fragmentFile.c_str(), program->vertexFile.c_str());
+            }
+        }
+    }
+    return swapped;
+}
@@ -0,0 +1,15 @@
+#ifndef __ShaderReloader_h__
+#define __ShaderReloader_h__
+
+#include "GLObjects.h"
+
+// Rebuild an already loaded shader program whenever one of its source files changes on disk
+// program is only ever replaced from inside UpdateShaderReloads, which deletes the old one; a rebuild
+// that fails to compile or link is reported and the old program is kept
+void WatchShaderProgram(Program* program, const char* fragmentFilePath, const char* vertexFilePath);
+// Pick up changed files, start rebuilding the programs that use them, and swap in finished rebuilds
+// Call once per frame at the frame boundary, after pumpAsyncLoads
+// Returns true if any program handle was replaced, so cached uniform locations must be looked up again
+bool UpdateShaderReloads();
+
+#endif
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <unordered_map>
+#include "Data.h"
+#include "ErrorHandling.h"
+#include "ShaderLoader.h"
+#include "ShaderVariants.h"
+
+struct ShaderVariant
+{
+    Program program;
+    bool built = false; // program is finished and ready to use
+    bool failed = false;
+};
+
+struct ShaderVariants
+{
+    std::string fragmentFilePath;
+    std::string vertexFilePath;
+    std::string fragmentSource;
+    std::string vertexSource;
+    std::vector<std::string> featureDefines;
+    std::unordered_map<uint64_t, ShaderVariant> cache;
+};
+
+ShaderVariants* CreateShaderVariants(const char* fragmentFilePath, const char* vertexFilePath, const std::vector<std::string>& featureDefines)
+{
+    if (featureDefines.size() > 64)
+        err_fatalf("%s and %s have %u features; at most 64 are supported", fragmentFilePath, vertexFilePath, (unsigned)featureDefines.size());
+
+    ShaderVariants* variants = new ShaderVariants();
+    variants->fragmentFilePath = fragmentFilePath;
+    variants->vertexFilePath = vertexFilePath;
+    variants->fragmentSource = loadFile(fragmentFilePath);
+    variants->vertexSource = loadFile(vertexFilePath);
+    variants->featureDefines = featureDefines;
+    return variants;
+}
+
+void DestroyShaderVariants(ShaderVariants* variants)
+{
+    delete variants;
+}
+
+// Find a variant, starting its build if this is the first time it has been asked for
+static ShaderVariant& StartVariant(ShaderVariants* variants, uint64_t features)
+{
+    ShaderVariant& variant = variants->cache[features];
+    if (!variant.program && !variant.failed)
+    {
+        std::vector<std::string> defines;
+        for (size_t i = 0; i < variants->featureDefines.size(); ++i)
+            if (features & ((uint64_t)1 << i))
+                defines.push_back(variants->featureDefines[i]);
+        variant.program = BeginShaderProgramSource(variants->fragmentSource.c_str(), variants->vertexSource.c_str(), defines);
+    }
+    return variant;
+}
+
+// Check on a build; waits for the driver if it is still going
+static void FinishVariant(ShaderVariants* variants, uint64_t features, ShaderVariant& variant)
+{
+    if (variant.built || variant.failed) return;
+    if (FinishShaderProgram(variant.program))
+    {
+        variant.built = true;
+    }
+    else
+    {
+        // FinishShaderProgram has already deleted it
+        fprintf(stderr, "Unable to build variant 0x%llx of %s and %s\n", (unsigned long long)features,
+            variants->fragmentFilePath.c_str(), variants->vertexFilePath.c_str());
+        variant.failed = true;
+    }
+}
+
+GLuint GetShaderVariant(ShaderVariants* variants, uint64_t features)
+{
+    ShaderVariant& variant = StartVariant(variants, features);
+    FinishVariant(variants, features, variant);
+    if (variant.failed)
+        err_fatalf("Variant 0x%llx of %s and %s failed to build", (unsigned long long)features,
+            variants->fragmentFilePath.c_str(), variants->vertexFilePath.c_str());
+    return variant.program.get();
+}
+
+bool TryGetShaderVariant(ShaderVariants* variants, uint64_t features, GLuint* program)
+{
+    ShaderVariant& variant = StartVariant(variants, features);
+    if (!variant.built && !variant.failed && IsShaderProgramReady(variant.program.get()))
+        FinishVariant(variants, features, variant);
+    if (!variant.built) return false;
+    *program = variant.program.get();
+    return true;
+}
+
+void PrewarmShaderVariants(ShaderVariants* variants, const std::vector<uint64_t>& featureSets)
+{
+    // Start everything before checking anything, so the driver can work on them all at once
+    for (uint64_t features : featureSets)
+        StartVariant(variants, features);
+}
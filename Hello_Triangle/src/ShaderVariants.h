@@ -0,0 +1,33 @@
+#ifndef __ShaderVariants_h__
+#define __ShaderVariants_h__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+
+// A shader program built in many variations by switching features on and off with #defines
+// Feature i is bit (1 << i) of a variant's mask; each variant is built the first time it is needed
+// and then cached by its mask
+struct ShaderVariants;
+
+// featureDefines lists the #define for each feature bit, e.g. { "SKINNING", "INSTANCING", "ALPHA_TEST" }
+// At most 64 features; the sources are read once, here
+ShaderVariants* CreateShaderVariants(const char* fragmentFilePath, const char* vertexFilePath, const std::vector<std::string>& featureDefines);
+// Delete every variant built so far
+void DestroyShaderVariants(ShaderVariants* variants);
+
+// Variants stay owned by the ShaderVariants; the program names handed out are only borrowed
+
+// Get a variant, building it right now if it has not been built yet
+// A variant that fails to build is fatal, the same as LoadShaderProgramSource
+GLuint GetShaderVariant(ShaderVariants* variants, uint64_t features);
+// Get a variant without stalling: the first call starts building it and returns false until it is done,
+// so callers can draw with something else in the meantime. A variant that fails to build is reported
+// and never becomes ready
+bool TryGetShaderVariant(ShaderVariants* variants, uint64_t features, GLuint* program);
+// Start building a known set of variants at load time, so none of them hitch on first use
+// With GL_ARB_parallel_shader_compile the driver builds them in the background
+void PrewarmShaderVariants(ShaderVariants* variants, const std::vector<uint64_t>& featureSets);
+
+#endif
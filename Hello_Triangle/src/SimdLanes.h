@@ -0,0 +1,52 @@
+#ifndef __SimdLanes_h__
+#define __SimdLanes_h__
+
+// The widest float vector the build targets, wrapped so loops over structure of arrays data are written
+// once: 8 lanes with AVX (build with -mavx or -march=native), 4 with SSE2, which every x86-64 target has.
+// Elsewhere SIMD_LANES is 1, nothing else is defined, and callers fall back to plain loops.
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SIMD_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_LANES 4
+#else
+#define SIMD_LANES 1
+#endif
+
+// Comparisons return lanes of all ones where they hold and all zeros elsewhere, for And, Or and LaneMask
+#if SIMD_LANES == 8
+typedef __m256 Lanes;
+static inline Lanes Load(const float* p) { return _mm256_loadu_ps(p); }
+static inline void Store(float* p, Lanes a) { _mm256_storeu_ps(p, a); }
+static inline Lanes Splat(float f) { return _mm256_set1_ps(f); }
+static inline Lanes LaneIndices() { return _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+static inline Lanes Add(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+static inline Lanes Mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+static inline Lanes Min(Lanes a, Lanes b) { return _mm256_min_ps(a, b); }
+static inline Lanes And(Lanes a, Lanes b) { return _mm256_and_ps(a, b); }
+static inline Lanes Or(Lanes a, Lanes b) { return _mm256_or_ps(a, b); }
+static inline Lanes Select(Lanes mask, Lanes a, Lanes b) { return _mm256_blendv_ps(b, a, mask); }
+static inline Lanes Zero() { return _mm256_setzero_ps(); }
+static inline Lanes LessThanZero(Lanes a) { return _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_LT_OQ); }
+static inline Lanes AtLeastZero(Lanes a) { return _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_GE_OQ); }
+static inline unsigned LaneMask(Lanes a) { return (unsigned)_mm256_movemask_ps(a); }
+#elif SIMD_LANES == 4
+typedef __m128 Lanes;
+static inline Lanes Load(const float* p) { return _mm_loadu_ps(p); }
+static inline void Store(float* p, Lanes a) { _mm_storeu_ps(p, a); }
+static inline Lanes Splat(float f) { return _mm_set1_ps(f); }
+static inline Lanes LaneIndices() { return _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f); }
+static inline Lanes Add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+static inline Lanes Mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+static inline Lanes Min(Lanes a, Lanes b) { return _mm_min_ps(a, b); }
+static inline Lanes And(Lanes a, Lanes b) { return _mm_and_ps(a, b); }
+static inline Lanes Or(Lanes a, Lanes b) { return _mm_or_ps(a, b); }
+static inline Lanes Select(Lanes mask, Lanes a, Lanes b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+static inline Lanes Zero() { return _mm_setzero_ps(); }
+static inline Lanes LessThanZero(Lanes a) { return _mm_cmplt_ps(a, _mm_setzero_ps()); }
+static inline Lanes AtLeastZero(Lanes a) { return _mm_cmpge_ps(a, _mm_setzero_ps()); }
+static inline unsigned LaneMask(Lanes a) { return (unsigned)_mm_movemask_ps(a); }
+#endif
+
+#endif
@@ -0,0 +1,102 @@
+#include <unordered_map>
+#include <vector>
+#include "ErrorHandling.h"
+#include "VertexArrayCache.h"
+
+// What a cached vertex array currently points at
+struct BufferBinding
+{
+    GLuint buffer = 0;
+    GLintptr offset = 0;
+    GLsizei stride = 0;
+};
+
+struct CachedVertexArray
+{
+    VertexArray vertexArray;
+    std::vector<BufferBinding> bindings;
+    GLuint elementBuffer = 0;
+};
+
+// By layout hash and binding point, and by vertex array for tracking bindings
+static std::unordered_map<uint64_t, GLuint> vertexArrays;
+static std::unordered_map<GLuint, CachedVertexArray> cachedVertexArrays;
+static GLuint boundVertexArray = 0;
+
+static CachedVertexArray& CreateCachedVertexArray()
+{
+    VertexArray vertexArray = CreateVertexArray();
+    CachedVertexArray& cached = cachedVertexArrays[vertexArray.get()];
+    cached.vertexArray = std::move(vertexArray);
+    return cached;
+}
+
+GLuint GetVertexArray(uint64_t layoutHash, GLuint binding, void (*apply)(GLuint vertexArray, GLuint binding))
+{
+    GLuint& vertexArray = vertexArrays[VertexLayoutHash(layoutHash, binding)];
+    if (vertexArray == 0)
+    {
+        err_checkGL("Before creating vertex array");
+        vertexArray = CreateCachedVertexArray().vertexArray.get();
+        apply(vertexArray, binding);
+        err_checkGL("Creating vertex array");
+    }
+    return vertexArray;
+}
+
+GLuint GetVertexPullingArray()
+{
+    static GLuint vertexArray = 0;
+    if (vertexArray == 0 || cachedVertexArrays.count(vertexArray) == 0)
+        vertexArray = CreateCachedVertexArray().vertexArray.get();
+    return vertexArray;
+}
+
+void BindVertexArray(GLuint vertexArray)
+{
+    if (vertexArray == boundVertexArray) return;
+    glBindVertexArray(vertexArray);
+    boundVertexArray = vertexArray;
+}
+
+void SetVertexBuffer(GLuint vertexArray, GLuint binding, GLuint buffer, GLintptr offset, GLsizei stride)
+{
+    CachedVertexArray& cached = cachedVertexArrays[vertexArray];
+    if (binding >= cached.bindings.size())
+        cached.bindings.resize(binding + 1);
+    BufferBinding& current = cached.bindings[binding];
+    if (current.buffer == buffer && current.offset == offset && current.stride == stride) return;
+
+    glVertexArrayVertexBuffer(vertexArray, binding, buffer, offset, stride);
+    current.buffer = buffer;
+    current.offset = offset;
+    current.stride = stride;
+}
+
+void SetElementBuffer(GLuint vertexArray, GLuint buffer)
+{
+    CachedVertexArray& cached = cachedVertexArrays[vertexArray];
+    if (cached.elementBuffer == buffer) return;
+
+    glVertexArrayElementBuffer(vertexArray, buffer);
+    cached.elementBuffer = buffer;
+}
+
+void ForgetVertexBuffer(GLuint buffer)
+{
+    for (std::pair<const GLuint, CachedVertexArray>& cached : cachedVertexArrays)
+    {
+        for (BufferBinding& binding : cached.second.bindings)
+            if (binding.buffer == buffer)
+                binding = BufferBinding();
+        if (cached.second.elementBuffer == buffer)
+            cached.second.elementBuffer = 0;
+    }
+}
+
+void ClearVertexArrayCache()
+{
+    BindVertexArray(0);
+    vertexArrays.clear();
+    cachedVertexArrays.clear();
+}
@@ -0,0 +1,49 @@
+#ifndef __VertexArrayCache_h__
+#define __VertexArrayCache_h__
+
+#include <stdint.h>
+#include <GL/glew.h>
+#include "VertexLayout.h"
+
+// Vertex arrays shared between every mesh with the same vertex format
+// A vertex array only holds the format; which buffers it reads is switched per draw with
+// glVertexArrayVertexBuffer, so drawing many meshes of one format never creates or switches vertex arrays.
+// Bindings are tracked, so rebinding what is already bound costs no GL calls at all.
+// Bind vertex arrays only through these functions, or the tracking goes stale.
+
+// The vertex array for a layout read from a buffer binding point, created on first use
+GLuint GetVertexArray(uint64_t layoutHash, GLuint binding, void (*apply)(GLuint vertexArray, GLuint binding));
+template <typename Layout>
+GLuint GetVertexArray(GLuint binding = 0)
+{
+    return GetVertexArray(Layout::hash, binding, &Layout::Apply);
+}
+
+// A vertex array with no attributes at all, for shaders that fetch their own vertices from storage
+// buffers (vertex pulling). Only the element buffer changes, so a whole mega-buffer pass binds it once
+GLuint GetVertexPullingArray();
+
+// Make a vertex array current
+void BindVertexArray(GLuint vertexArray);
+// Point a vertex array's binding point at a buffer range, and its indices at an element buffer
+void SetVertexBuffer(GLuint vertexArray, GLuint binding, GLuint buffer, GLintptr offset, GLsizei stride);
+void SetElementBuffer(GLuint vertexArray, GLuint buffer);
+
+// Everything needed for a draw of Layout from one vertex buffer and one element buffer
+template <typename Layout>
+GLuint BindVertexLayout(GLuint vertexBuffer, GLintptr offset, GLuint elementBuffer)
+{
+    GLuint vertexArray = GetVertexArray<Layout>();
+    SetVertexBuffer(vertexArray, 0, vertexBuffer, offset, Layout::stride);
+    SetElementBuffer(vertexArray, elementBuffer);
+    BindVertexArray(vertexArray);
+    return vertexArray;
+}
+
+// Call before deleting a buffer that cached vertex arrays may still point at, so a new buffer reusing
+// its name is not mistaken for one that is already bound
+void ForgetVertexBuffer(GLuint buffer);
+// Delete every cached vertex array; call before the context goes away
+void ClearVertexArrayCache();
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef __VertexLayout_h__
+#define __VertexLayout_h__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include "GLObjects.h"
+
+// Vertex formats described by the C++ vertex struct itself
+// Offsets, strides and GL types are all worked out at compile time, and the description is checked
+// against the struct with static_asserts, so the VAO setup it generates cannot get out of step with it:
+//
+//   struct Vertex { vec3 position; vec2 uv; };
+//   typedef VertexLayout<Vertex,
+//       VERTEX_ATTRIBUTE(0, Vertex, position),
+//       VERTEX_ATTRIBUTE(1, Vertex, uv)> VertexFormat;
+//   VertexArray vertexArray = CreateVertexArray<VertexFormat>(vertexBuffer.get());
+
+// Packed members, for compressed vertex formats (see VertexQuantization.h)
+// x, y, z and w as 10, 10, 10 and 2 bit signed normalized values in one word, x lowest; glm::packSnorm3x10_1x2 makes one
+struct PackedSnorm10
+{
+    uint32_t bits;
+};
+// x and y as half floats in one word, x lowest; glm::packHalf2x16 makes one
+struct PackedHalf2
+{
+    uint32_t bits;
+};
+
+// How GL reads a member of a given C++ type
+// Integer types stay integers in the shader (ivec/uvec inputs); 8 and 16 bit vectors are normalized to [0, 1]
+template <typename T>
+struct VertexFormat
+{
+    static_assert(sizeof(T) == 0, "No vertex format for this type; add a VertexFormat specialization");
+};
+
+#define DEFINE_VERTEX_FORMAT(Type, Count, GLType, Normalized, Integer) \
+    template <> \
+    struct VertexFormat<Type> \
+    { \
+        static constexpr GLint count = Count; \
+        static constexpr GLenum type = GLType; \
+        static constexpr GLboolean normalized = Normalized; \
+        static constexpr bool integer = Integer; \
+    };
+
+DEFINE_VERTEX_FORMAT(GLfloat, 1, GL_FLOAT, GL_FALSE, false)
+DEFINE_VERTEX_FORMAT(glm::vec2, 2, GL_FLOAT, GL_FALSE, false)
+DEFINE_VERTEX_FORMAT(glm::vec3, 3, GL_FLOAT, GL_FALSE, false)
+DEFINE_VERTEX_FORMAT(glm::vec4, 4, GL_FLOAT, GL_FALSE, false)
+DEFINE_VERTEX_FORMAT(GLint, 1, GL_INT, GL_FALSE, true)
+DEFINE_VERTEX_FORMAT(glm::ivec2, 2, GL_INT, GL_FALSE, true)
+DEFINE_VERTEX_FORMAT(glm::ivec3, 3, GL_INT, GL_FALSE, true)
+DEFINE_VERTEX_FORMAT(glm::ivec4, 4, GL_INT, GL_FALSE, true)
+DEFINE_VERTEX_FORMAT(GLuint, 1, GL_UNSIGNED_INT, GL_FALSE, true)
+DEFINE_VERTEX_FORMAT(glm::uvec2, 2, GL_UNSIGNED_INT, GL_FALSE, true)
+DEFINE_VERTEX_FORMAT(glm::uvec3, 3, GL_UNSIGNED_INT, GL_FALSE, true)
+DEFINE_VERTEX_FORMAT(glm::uvec4, 4, GL_UNSIGNED_INT, GL_FALSE, true)
+DEFINE_VERTEX_FORMAT(glm::u8vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, false)
+DEFINE_VERTEX_FORMAT(glm::u16vec2, 2, GL_UNSIGNED_SHORT, GL_TRUE, false)
+DEFINE_VERTEX_FORMAT(glm::u16vec4, 4, GL_UNSIGNED_SHORT, GL_TRUE, false)
+DEFINE_VERTEX_FORMAT(PackedSnorm10, 4, GL_INT_2_10_10_10_REV, GL_TRUE, false)
+DEFINE_VERTEX_FORMAT(PackedHalf2, 2, GL_HALF_FLOAT, GL_FALSE, false)
+
+// Size in bytes of one component of a GL type
+constexpr size_t VertexComponentSize(GLenum type)
+{
+    return type == GL_BYTE || type == GL_UNSIGNED_BYTE ? 1
+        : type == GL_SHORT || type == GL_UNSIGNED_SHORT || type == GL_HALF_FLOAT ? 2
+        : type == GL_DOUBLE ? 8
+        : 4;
+}
+
+// Size in bytes of a whole member; packed types hold every component in one word
+constexpr size_t VertexFormatSize(GLenum type, GLint count)
+{
+    return type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_10F_11F_11F_REV ? 4
+        : count * VertexComponentSize(type);
+}
+
+// One step of FNV-1a over a 64-bit value, for identifying layouts
+constexpr uint64_t VertexLayoutHash(uint64_t hash, uint64_t value)
+{
+    return (hash ^ value) * 1099511628211ull;
+}
+
+// One member of a vertex struct; use VERTEX_ATTRIBUTE rather than spelling out the offset
+template <GLuint Location, typename Vertex, typename T, size_t Offset>
+struct VertexAttribute
+{
+    typedef VertexFormat<T> Format;
+    typedef Vertex VertexType; // the struct the member belongs to
+    static constexpr GLuint location = Location;
+    static constexpr size_t offset = Offset;
+    static constexpr size_t size = sizeof(T);
+
+    static_assert(size == VertexFormatSize(Format::type, Format::count), "Member is padded; GL would read it at the wrong size");
+    static_assert(Offset % VertexComponentSize(Format::type) == 0, "Member is not aligned to its component size");
+    static_assert(Offset <= 2047, "Member offset is beyond the smallest GL_MAX_VERTEX_ATTRIB_RELATIVE_OFFSET");
+    static_assert(Location < 16, "Location is beyond the smallest GL_MAX_VERTEX_ATTRIBS");
+
+    // Everything Apply sets, folded into a running hash of the layout
+    static constexpr uint64_t Hash(uint64_t hash)
+    {
+        return VertexLayoutHash(VertexLayoutHash(VertexLayoutHash(VertexLayoutHash(VertexLayoutHash(hash,
+            Location), (uint64_t)Format::count), Format::type), (uint64_t)Format::normalized << 1 | Format::integer), Offset);
+    }
+
+    static void Apply(GLuint vertexArray, GLuint binding)
+    {
+        glEnableVertexArrayAttrib(vertexArray, Location);
+        glVertexArrayAttribBinding(vertexArray, Location, binding);
+        if (Format::integer)
+            glVertexArrayAttribIFormat(vertexArray, Location, Format::count, Format::type, (GLuint)Offset);
+        else
+            glVertexArrayAttribFormat(vertexArray, Location, Format::count, Format::type, Format::normalized, (GLuint)Offset);
+    }
+};
+
+#define VERTEX_ATTRIBUTE(location, Vertex, member) \
+    VertexAttribute<location, Vertex, decltype(Vertex::member), offsetof(Vertex, member)>
+
+// Compile-time checks across every attribute of a layout
+template <typename... Attributes>
+struct VertexAttributeChecks
+{
+    static constexpr bool uniqueLocations = true;
+    static constexpr bool disjoint = true;
+    static constexpr size_t end = 0;
+    template <typename Vertex> static constexpr bool membersOf() { return true; }
+    static constexpr bool locationUnused(GLuint) { return true; }
+    static constexpr bool rangeUnused(size_t, size_t) { return true; }
+    static constexpr uint64_t hash(uint64_t hash) { return hash; }
+};
+
+template <typename First, typename... Rest>
+struct VertexAttributeChecks<First, Rest...>
+{
+    typedef VertexAttributeChecks<Rest...> RestChecks;
+    static constexpr bool locationUnused(GLuint location)
+    {
+        return location != First::location && RestChecks::locationUnused(location);
+    }
+    static constexpr bool rangeUnused(size_t offset, size_t size)
+    {
+        return (offset + size <= First::offset || First::offset + First::size <= offset) && RestChecks::rangeUnused(offset, size);
+    }
+    static constexpr uint64_t hash(uint64_t hash)
+    {
+        return RestChecks::hash(First::Hash(hash));
+    }
+    template <typename Vertex>
+    static constexpr bool membersOf()
+    {
+        return std::is_same<typename First::VertexType, Vertex>::value && RestChecks::template membersOf<Vertex>();
+    }
+    static constexpr bool uniqueLocations = RestChecks::locationUnused(First::location) && RestChecks::uniqueLocations;
+    static constexpr bool disjoint = RestChecks::rangeUnused(First::offset, First::size) && RestChecks::disjoint;
+    // One past the last byte any attribute reads
+    static constexpr size_t end = First::offset + First::size > RestChecks::end ? First::offset + First::size : RestChecks::end;
+};
+
+template <typename Vertex, typename... Attributes>
+struct VertexLayout
+{
+    typedef Vertex VertexType;
+    static constexpr GLsizei stride = sizeof(Vertex);
+    // Identifies the attribute formats, whatever struct they come from; layouts with the same hash can share a vertex array
+    static constexpr uint64_t hash = VertexAttributeChecks<Attributes...>::hash(14695981039346656037ull);
+
+    static_assert(std::is_standard_layout<Vertex>::value, "Vertex structs must be standard layout for offsetof to be meaningful");
+    static_assert(sizeof...(Attributes) > 0, "A vertex layout needs at least one attribute");
+    static_assert(VertexAttributeChecks<Attributes...>::uniqueLocations, "Two attributes share a location");
+    static_assert(VertexAttributeChecks<Attributes...>::disjoint, "Two attributes overlap");
+    static_assert(VertexAttributeChecks<Attributes...>::template membersOf<Vertex>(), "An attribute is a member of another vertex struct");
+    static_assert(VertexAttributeChecks<Attributes...>::end <= sizeof(Vertex), "An attribute reads past the end of the vertex");
+    static_assert(sizeof(Vertex) <= 2048, "Vertex is bigger than the smallest GL_MAX_VERTEX_ATTRIB_STRIDE");
+
+    // Set up the attributes of a vertex array to read this layout from a buffer binding point
+    static void Apply(GLuint vertexArray, GLuint binding)
+    {
+        int expand[] = { 0, (Attributes::Apply(vertexArray, binding), 0)... };
+        (void)expand;
+    }
+};
+
+// A vertex array reading Layout from binding point 0 of vertexBuffer
+template <typename Layout>
+VertexArray CreateVertexArray(GLuint vertexBuffer, GLintptr offset = 0)
+{
+    VertexArray vertexArray = CreateVertexArray();
+    Layout::Apply(vertexArray.get(), 0);
+    glVertexArrayVertexBuffer(vertexArray.get(), 0, vertexBuffer, offset, Layout::stride);
+    return vertexArray;
+}
+
+#endif
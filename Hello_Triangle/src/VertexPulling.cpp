@@ -0,0 +1,32 @@
+#include "ErrorHandling.h"
+#include "VertexArrayCache.h"
+#include "VertexPulling.h"
+
+bool IsVertexPullingSupported()
+{
+    return GLEW_VERSION_4_6 || GLEW_ARB_shader_draw_parameters;
+}
+
+VertexPullingDraw MakeVertexPullingDraw(GLintptr firstByte, GLsizei stride, GLuint positionOffset)
+{
+    if (firstByte % 4 != 0 || stride % 4 != 0 || positionOffset % 4 != 0)
+        err_fatalf("Pulled vertices must be 4-byte aligned (first byte %lld, stride %d, position offset %u)",
+            (long long)firstByte, (int)stride, positionOffset);
+
+    VertexPullingDraw draw;
+    draw.firstWord = (GLuint)(firstByte / 4);
+    draw.strideWords = (GLuint)(stride / 4);
+    draw.positionWord = positionOffset / 4;
+    draw.padding = 0;
+    return draw;
+}
+
+void BindVertexPulling(GLuint vertexBuffer, GLuint drawBuffer, GLuint elementBuffer)
+{
+    // No attributes, so the same vertex array serves every format
+    GLuint vertexArray = GetVertexPullingArray();
+    SetElementBuffer(vertexArray, elementBuffer);
+    BindVertexArray(vertexArray);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VERTEX_PULLING_VERTEX_BINDING, vertexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VERTEX_PULLING_DRAW_BINDING, drawBuffer);
+}
@@ -0,0 +1,37 @@
+#ifndef __VertexPulling_h__
+#define __VertexPulling_h__
+
+#include <GL/glew.h>
+
+// Vertex pulling: vertex shaders read their own vertices out of shader storage buffers with gl_VertexID,
+// instead of having fixed-function attribute fetch do it through vertex array state. With nothing about
+// the vertex format left in the vertex array, meshes of any number of formats can go in one
+// glMultiDrawElementsIndirect; each draw finds where and how its vertices are stored through gl_DrawIDARB.
+// See data/BasicPulled.vert for the shader side.
+
+// Storage buffer binding points the shaders read from
+const GLuint VERTEX_PULLING_VERTEX_BINDING = 0; // every mesh's vertices, as a float array
+const GLuint VERTEX_PULLING_DRAW_BINDING = 1;   // a VertexPullingDraw per indirect draw command
+
+// Where one draw's vertices are, in 4-byte words; matches struct PulledDraw in the shaders (std430)
+// Draw commands should leave baseVertex at 0, so gl_VertexID is the index within the mesh
+struct VertexPullingDraw
+{
+    GLuint firstWord;     // first word of the mesh's first vertex
+    GLuint strideWords;   // words from one vertex to the next
+    GLuint positionWord;  // word of the position within a vertex
+    GLuint padding;
+};
+static_assert(sizeof(VertexPullingDraw) == 16, "VertexPullingDraw must match its std430 layout");
+
+// Whether the driver has gl_DrawIDARB (OpenGL 4.6 or GL_ARB_shader_draw_parameters)
+bool IsVertexPullingSupported();
+
+// Describe a mesh starting firstByte into the vertex buffer, with its position positionOffset bytes into each vertex
+// Everything must be a multiple of 4 bytes
+VertexPullingDraw MakeVertexPullingDraw(GLintptr firstByte, GLsizei stride, GLuint positionOffset);
+
+// Bind the vertex array, element buffer and storage buffers for a pulled pass
+void BindVertexPulling(GLuint vertexBuffer, GLuint drawBuffer, GLuint elementBuffer);
+
+#endif
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <math.h>
+#include <glm/gtc/packing.hpp>
+#include "VertexQuantization.h"
+
+glm::u16vec4 QuantizePosition(const glm::vec3& position, const glm::vec3& offset, const glm::vec3& scale)
+{
+    glm::u16vec4 quantized;
+    for (int c = 0; c < 3; ++c)
+    {
+        float t = scale[c] > 0.0f ? (position[c] - offset[c]) / scale[c] : 0.0f;
+        quantized[c] = (uint16_t)lrintf(std::min(std::max(t, 0.0f), 1.0f) * 65535.0f);
+    }
+    quantized.w = 0;
+    return quantized;
+}
+
+PackedSnorm10 PackSnorm10(const glm::vec4& value)
+{
+    PackedSnorm10 packed = { glm::packSnorm3x10_1x2(value) };
+    return packed;
+}
+
+PackedHalf2 PackHalf2(const glm::vec2& value)
+{
+    PackedHalf2 packed = { glm::packHalf2x16(value) };
+    return packed;
+}
+
+static glm::vec3 SafeNormalize(const glm::vec3& v, const glm::vec3& fallback)
+{
+    float length = sqrtf(glm::dot(v, v));
+    return length > 1e-20f ? v * (1.0f / length) : fallback;
+}
+
+// Per vertex tangents from the uv gradients of the triangles around it (Lengyel's method), made
+// orthogonal to the normal; the sign records whether the uvs are mirrored
+static void ComputeTangents(const ObjMesh& mesh, std::vector<glm::vec4>& tangents)
+{
+    size_t vertexCount = mesh.vertices.size();
+    std::vector<glm::vec3> uDirections(vertexCount, glm::vec3(0.0f)), vDirections(vertexCount, glm::vec3(0.0f));
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        const ObjVertex& a = mesh.vertices[mesh.indices[i]];
+        const ObjVertex& b = mesh.vertices[mesh.indices[i + 1]];
+        const ObjVertex& c = mesh.vertices[mesh.indices[i + 2]];
+        glm::vec3 e1 = b.position - a.position, e2 = c.position - a.position;
+        float du1 = b.uv.x - a.uv.x, dv1 = b.uv.y - a.uv.y;
+        float du2 = c.uv.x - a.uv.x, dv2 = c.uv.y - a.uv.y;
+        float determinant = du1 * dv2 - du2 * dv1;
+        if (fabsf(determinant) < 1e-20f) continue;
+        float r = 1.0f / determinant;
+        glm::vec3 u = (e1 * dv2 - e2 * dv1) * r;
+        glm::vec3 v = (e2 * du1 - e1 * du2) * r;
+        for (int k = 0; k < 3; ++k)
+        {
+            uDirections[mesh.indices[i + k]] += u;
+            vDirections[mesh.indices[i + k]] += v;
+        }
+    }
+
+    tangents.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        glm::vec3 n = SafeNormalize(mesh.vertices[i].normal, glm::vec3(0.0f, 0.0f, 1.0f));
+        // Any direction across the normal will do where the uvs give none
+        glm::vec3 across = fabsf(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::vec3 t = SafeNormalize(uDirections[i] - n * glm::dot(n, uDirections[i]), SafeNormalize(glm::cross(across, n), across));
+        float sign = glm::dot(glm::cross(n, t), vDirections[i]) < 0.0f ? -1.0f : 1.0f;
+        tangents[i] = glm::vec4(t.x, t.y, t.z, sign);
+    }
+}
+
+void QuantizeObjMesh(const ObjMesh& mesh, QuantizedMesh& quantized)
+{
+    glm::vec3 low(0.0f), high(0.0f);
+    if (!mesh.vertices.empty())
+        low = high = mesh.vertices[0].position;
+    for (const ObjVertex& vertex : mesh.vertices)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            low[c] = std::min(low[c], vertex.position[c]);
+            high[c] = std::max(high[c], vertex.position[c]);
+        }
+    }
+    quantized.positionOffset = low;
+    quantized.positionScale = high - low;
+
+    std::vector<glm::vec4> tangents;
+    ComputeTangents(mesh, tangents);
+    quantized.vertices.resize(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i)
+    {
+        const ObjVertex& vertex = mesh.vertices[i];
+        glm::vec3 normal = SafeNormalize(vertex.normal, glm::vec3(0.0f));
+        QuantizedVertex& q = quantized.vertices[i];
+        q.position = QuantizePosition(vertex.position, quantized.positionOffset, quantized.positionScale);
+        q.normal = PackSnorm10(glm::vec4(normal.x, normal.y, normal.z, 0.0f));
+        q.tangent = PackSnorm10(tangents[i]);
+        q.uv = PackHalf2(vertex.uv);
+    }
+    quantized.indices = mesh.indices;
+}
+
+glm::mat4 QuantizedPositionMatrix(const QuantizedMesh& mesh)
+{
+    glm::mat4 matrix(1.0f);
+    for (int c = 0; c < 3; ++c)
+    {
+        matrix[c][c] = mesh.positionScale[c];
+        matrix[3][c] = mesh.positionOffset[c];
+    }
+    return matrix;
+}
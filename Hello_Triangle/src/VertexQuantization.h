@@ -0,0 +1,51 @@
+#ifndef __VertexQuantization_h__
+#define __VertexQuantization_h__
+
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include "ObjImporter.h"
+#include "VertexLayout.h"
+
+// Compressed vertices: 20 bytes, where the same attributes as floats take 48
+// Positions are 16 bit fractions of the mesh's bounding box, so a mesh 100 m across keeps 1.5 mm steps;
+// normals and tangents keep 10 bits per component, and uvs are half floats, exact to 1/2048 across [0, 1].
+// GL unpacks everything in the vertex fetch, so shaders see the usual vec3/vec4/vec2 inputs.
+struct QuantizedVertex
+{
+    glm::u16vec4 position; // x, y, z across the mesh bounds; w is unused
+    PackedSnorm10 normal;  // w is 0
+    PackedSnorm10 tangent; // w is the bitangent sign: bitangent = cross(normal, tangent.xyz) * tangent.w
+    PackedHalf2 uv;
+};
+
+// Locations match ObjVertexLayout, and the tangent the one glTF scenes use
+typedef VertexLayout<QuantizedVertex,
+    VERTEX_ATTRIBUTE(0, QuantizedVertex, position),
+    VERTEX_ATTRIBUTE(1, QuantizedVertex, normal),
+    VERTEX_ATTRIBUTE(2, QuantizedVertex, uv),
+    VERTEX_ATTRIBUTE(3, QuantizedVertex, tangent)> QuantizedVertexLayout;
+
+struct QuantizedMesh
+{
+    std::vector<QuantizedVertex> vertices;
+    std::vector<uint32_t> indices;
+    // position = positionOffset + positionScale * position as read, which is in [0, 1]
+    glm::vec3 positionOffset;
+    glm::vec3 positionScale;
+};
+
+// Compress an imported OBJ; the indices are unchanged, and tangents are worked out from the uvs
+void QuantizeObjMesh(const ObjMesh& mesh, QuantizedMesh& quantized);
+
+// The dequantization as a model matrix, so shaders need no changes: multiply it onto the right of the
+// mesh's model matrix
+glm::mat4 QuantizedPositionMatrix(const QuantizedMesh& mesh);
+
+// The packing itself, for building compressed vertices some other way
+glm::u16vec4 QuantizePosition(const glm::vec3& position, const glm::vec3& offset, const glm::vec3& scale);
+PackedSnorm10 PackSnorm10(const glm::vec4& value);
+PackedHalf2 PackHalf2(const glm::vec2& value);
+
+#endif
@@ -0,0 +1,122 @@
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include "WorkerPool.h"
+
+struct WorkerPool
+{
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;     // a job was posted, or the pool is stopping
+    std::condition_variable finished; // the last worker left a job
+    uint64_t generation = 0;          // counts jobs posted, so workers can tell a new one from the last
+    bool stopping = false;
+    unsigned busy = 0;                // workers inside the current job
+
+    // The current job; body is cleared once the caller has seen every worker leave it
+    const std::function<void(size_t, size_t)>* body = nullptr;
+    size_t count = 0;
+    size_t blockSize = 0;
+    std::atomic<size_t> nextBlock;
+
+    WorkerPool();
+    ~WorkerPool();
+    void RunBlocks(const std::function<void(size_t, size_t)>& job, size_t jobCount, size_t jobBlockSize);
+    void WorkerLoop();
+};
+
+WorkerPool::WorkerPool() : nextBlock(0)
+{
+    unsigned cores = std::thread::hardware_concurrency();
+    for (unsigned i = 1; i < cores; ++i)
+        threads.emplace_back(&WorkerPool::WorkerLoop, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+// Claim blocks until none are left
+void WorkerPool::RunBlocks(const std::function<void(size_t, size_t)>& job, size_t jobCount, size_t jobBlockSize)
+{
+    size_t blockCount = (jobCount + jobBlockSize - 1) / jobBlockSize;
+    for (size_t block = nextBlock.fetch_add(1); block < blockCount; block = nextBlock.fetch_add(1))
+    {
+        size_t begin = block * jobBlockSize;
+        job(begin, begin + jobBlockSize < jobCount ? begin + jobBlockSize : jobCount);
+    }
+}
+
+void WorkerPool::WorkerLoop()
+{
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        // Woken too late: the caller has already finished this job by itself
+        if (body == nullptr) continue;
+
+        const std::function<void(size_t, size_t)>& job = *body;
+        size_t jobCount = count, jobBlockSize = blockSize;
+        ++busy;
+        lock.unlock();
+        RunBlocks(job, jobCount, jobBlockSize);
+        lock.lock();
+        if (--busy == 0) finished.notify_all();
+    }
+}
+
+static WorkerPool& GetWorkerPool()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+void ParallelFor(size_t count, size_t blockSize, const std::function<void(size_t begin, size_t end)>& body)
+{
+    if (count == 0) return;
+    if (blockSize == 0) blockSize = 1;
+    WorkerPool& pool = GetWorkerPool();
+    if (count <= blockSize || pool.threads.empty())
+    {
+        for (size_t begin = 0; begin < count; begin += blockSize)
+            body(begin, begin + blockSize < count ? begin + blockSize : count);
+        return;
+    }
+
+    static std::mutex callMutex;
+    std::lock_guard<std::mutex> call(callMutex);
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.body = &body;
+        pool.count = count;
+        pool.blockSize = blockSize;
+        pool.nextBlock = 0;
+        ++pool.generation;
+    }
+    pool.wake.notify_all();
+    pool.RunBlocks(body, count, blockSize);
+
+    // Every block has been claimed; wait for the workers still running theirs
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.finished.wait(lock, [&] { return pool.busy == 0; });
+    pool.body = nullptr;
+}
+
+unsigned WorkerThreadCount()
+{
+    return (unsigned)GetWorkerPool().threads.size() + 1;
+}
@@ -0,0 +1,18 @@
+#ifndef __WorkerPool_h__
+#define __WorkerPool_h__
+#include <stddef.h>
+#include <functional>
+
+// Threads kept running for work that is split across every core each frame, such as culling, where
+// starting threads for each call would cost more than the work itself. One thread per core is started
+// the first time it is needed, the calling thread counting as one of them.
+
+// Call body(begin, end) for consecutive blocks of blockSize covering [0, count), spread over the workers
+// and the calling thread, and return once every block is done. One call runs at a time; body must not
+// call ParallelFor itself
+void ParallelFor(size_t count, size_t blockSize, const std::function<void(size_t begin, size_t end)>& body);
+
+// How many threads ParallelFor spreads work over, the caller included
+unsigned WorkerThreadCount();
+
+#endif
@@ -10,31 +10,30 @@
 
 using namespace glm;
 
+#include "AsyncLoader.h"
+#include "DrawCommands.h"
 #include "ErrorHandling.h"
+#include "GLObjects.h"
+#include "Gltf.h"
+#include "IndexBuffer.h"
+#include "MeshLod.h"
+#include "Mesh.h"
+#include "Meshlets.h"
+#include "ObjImporter.h"
 #include "ShaderLoader.h"
+#include "ShaderReloader.h"
+#include "VertexArrayCache.h"
+#include "VertexPulling.h"
+#include "VertexLayout.h"
+#include "VertexQuantization.h"
 
 const int WINDOW_WIDTH = 640;
 const int WINDOW_HEIGHT = 480;
 
-typedef struct {
-    GLuint count;
-    GLuint primCount;
-    GLuint first;
-    GLuint baseInstance;
-} DrawArraysIndirectCommand;
-
-typedef struct {
-    GLuint count;
-    GLuint primCount;
-    GLuint firstIndex;
-    GLuint baseVertex;
-    GLuint baseInstance;
-} DrawElementsIndirectCommand;
-
 #ifdef _WIN32
-int wmain(int, char**)
+int wmain(int argc, char** argv)
 #else
-int main(int, char**)
+int main(int argc, char** argv)
 #endif
 {
     SDL_Init(SDL_INIT_VIDEO);
@@ -74,60 +73,122 @@ int main(int, char**)
     else if(!GLEW_VERSION_4_5)
         err_fatalf("Failed to initialize GLEW: OpenGL 4.5 extensions not supported/loaded");
 
+    // Let the driver build shader programs on its own threads, so rebuilds and shader variants don't stall frames
+    if (GLEW_ARB_parallel_shader_compile)
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+
+    // Index buffers end triangle strips with the largest value of their type
+    glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+
     err_clearGL();
 
-    GLuint VertexArrayID;
-    glCreateVertexArrays(1, &VertexArrayID);
-    static const GLfloat g_vertex_buffer_data[] = {
-        -1.0f, -1.0f, 0.0f,
-        1.0f, -1.0f, 0.0f,
-        0.0f, 1.0f, 0.0f,
-    };
-    // This will identify our vertex buffer
-    GLuint vertexbuffer;
+    // Start reading the shaders now, so the disk access overlaps with creating the buffers
+    std::future<std::string> fragmentSource = loadFileAsync("basic.frag");
+    std::future<std::string> vertexSource = loadFileAsync("basic.vert");
+
+    // A glTF or GLB scene named on the command line is drawn a batch at a time instead
+    GltfScene scene;
+    bool drawScene = argc > 1 && IsGltfPath(argv[1]) && LoadGltf(argv[1], scene);
+    // Draws hidden behind the scene's biggest meshes are culled on the CPU, at a quarter of the window's size
+    if (drawScene)
+        ResizeOcclusionBuffer(scene.occlusion, WINDOW_WIDTH / 4, WINDOW_HEIGHT / 4);
 
-    // Generate 1 buffer, put the resulting identifier in vertexbuffer
-    glCreateBuffers(1, &vertexbuffer);
+    // A binary mesh written by ObjToMesh goes from the file straight into GL buffers, with nothing parsed
+    Mesh binaryMesh;
+    bool drawBinaryMesh = argc > 1 && IsMeshPath(argv[1]) && LoadMesh(argv[1], binaryMesh);
+
+    // Draw the OBJ model named on the command line, or a triangle without one
+    ObjMesh mesh;
+    if (argc < 2 || IsGltfPath(argv[1]) || IsMeshPath(argv[1]) || !ImportObj(argv[1], mesh))
+    {
+        mesh.vertices = {
+            { vec3(-1.0f, -1.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), vec2(0.0f, 0.0f) },
+            { vec3(1.0f, -1.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), vec2(1.0f, 0.0f) },
+            { vec3(0.0f, 1.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f), vec2(0.5f, 1.0f) },
+        };
+        mesh.indices = { 0, 1, 2 };
+    }
+    // This will identify our vertex buffer
+    Buffer vertexBuffer = CreateBuffer();
 
     // Give our vertices to OpenGL.
-    glNamedBufferData(vertexbuffer, sizeof(g_vertex_buffer_data), g_vertex_buffer_data, GL_STATIC_DRAW);
-    // 1rst attribute buffer : vertices
-    glEnableVertexArrayAttrib(VertexArrayID, 0);
-    glVertexArrayAttribBinding(VertexArrayID, 0, 0);
-    glVertexArrayAttribFormat(VertexArrayID,
-        0,                  // attribute 0. No particular reason for 0, but must match the layout in the shader.
-        3,                  // size
-        GL_FLOAT,           // type
-        GL_FALSE,           // normalized?
-        0                   // relative offset
-        );
-    glVertexArrayVertexBuffer(VertexArrayID, 0, vertexbuffer, 0 /* offset */, 3 * sizeof(GLfloat) /* stride */);
+    glNamedBufferData(vertexBuffer.get(), mesh.vertices.size() * sizeof(ObjVertex), mesh.vertices.data(), GL_STATIC_DRAW);
     err_checkGL("Loading Triangle");
 
-    GLuint indices[3] = { 0, 1, 2 };
-    // Generate a buffer for the indices
-    GLuint elementbuffer;
-    glCreateBuffers(1, &elementbuffer);
-    glNamedBufferData(elementbuffer, 3 * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+    // The same vertices compressed to 20 bytes each; press Q to draw these instead
+    QuantizedMesh quantizedMesh;
+    QuantizeObjMesh(mesh, quantizedMesh);
+    Buffer quantizedVertexBuffer = CreateBuffer();
+    glNamedBufferData(quantizedVertexBuffer.get(), quantizedMesh.vertices.size() * sizeof(QuantizedVertex), quantizedMesh.vertices.data(), GL_STATIC_DRAW);
+    err_checkGL("Loading Quantized Triangle");
+    // Positions arrive in [0, 1] across the mesh bounds; this puts them back as part of the model matrix
+    mat4 Dequantize = QuantizedPositionMatrix(quantizedMesh);
+    bool quantized = false;
+
+    // Simplified levels of detail over the same vertices, picked each frame by how far away the mesh is
+    MeshLodChain lods;
+    BuildMeshLods(mesh.indices.data(), mesh.indices.size(), &mesh.vertices[0].position.x, mesh.vertices.size(), sizeof(ObjVertex), lods);
+
+    // Generate a buffer for the indices of every level, as strips where that is shorter, in the smallest type that fits
+    std::vector<IndexRange> lodRanges = lods.levels;
+    IndexData indexData;
+    BuildIndexData(lods.indices.data(), lodRanges, true, indexData);
+    Buffer elementBuffer = CreateBuffer();
+    glNamedBufferData(elementBuffer.get(), indexData.bytes.size(), indexData.bytes.data(), GL_STATIC_DRAW);
     err_checkGL("Loading Element Buffer");
 
     DrawElementsIndirectCommand elementsCommand = {
-        3, // count
+        lodRanges[0].count, // count
         1, // primcount
-        0, // firstIndex
+        lodRanges[0].firstIndex, // firstIndex
         0, // Specifies a constant that should be added to each element of indices when chosing elements from the enabled vertex arrays
         0  // Number to start from for InstanceId
     };
 
-    GLuint elementCommandBuffer;
-    glCreateBuffers(1, &elementCommandBuffer);
-    glNamedBufferData(elementCommandBuffer, sizeof(DrawElementsIndirectCommand), &elementsCommand, GL_STATIC_DRAW);
+    // The same triangles again in meshlets, which a compute pass culls each frame; press M to draw these
+    MeshletMesh meshletMesh;
+    BuildMeshlets(mesh.indices.data(), mesh.indices.size(), &mesh.vertices[0].position.x, mesh.vertices.size(), sizeof(ObjVertex), meshletMesh);
+    IndexData meshletIndexData;
+    BuildIndexData(meshletMesh.indices.data(), meshletMesh.indices.size(), false, meshletIndexData);
+    Buffer meshletElementBuffer = CreateBuffer();
+    glNamedBufferData(meshletElementBuffer.get(), meshletIndexData.bytes.size(), meshletIndexData.bytes.data(), GL_STATIC_DRAW);
+    MeshletCuller meshletCuller;
+    CreateMeshletCuller(meshletMesh, meshletCuller);
+    bool meshlets = false;
+
+    Buffer elementCommandBuffer = CreateBuffer();
+    glNamedBufferData(elementCommandBuffer.get(), sizeof(DrawElementsIndirectCommand), &elementsCommand, GL_DYNAMIC_DRAW);
+    size_t currentLod = 0;
 
     err_checkGL("Loading Command Buffer");
 
-    GLuint programID = LoadShaderProgramFile("basic.frag", "basic.vert");
-    // Get a handle for our "MVP" uniform.
-    GLuint MatrixID = glGetUniformLocation(programID, "MVP");
+    // The same triangle, described for vertex pulling
+    VertexPullingDraw pullingDraw = MakeVertexPullingDraw(0, ObjVertexLayout::stride, offsetof(ObjVertex, position));
+    Buffer pullingDrawBuffer = CreateBuffer();
+    glNamedBufferData(pullingDrawBuffer.get(), sizeof(VertexPullingDraw), &pullingDraw, GL_STATIC_DRAW);
+    err_checkGL("Loading Vertex Pulling Buffer");
+
+    // The SPIR-V built from the shaders skips the driver's GLSL compiler; without it, the GLSL read above is compiled
+    Program program = IsSpirvSupported() ? LoadShaderProgramSpirvFile("basic.frag", "basic.vert")
+        : LoadShaderProgramSource(fragmentSource.get().c_str(), vertexSource.get().c_str());
+    WatchShaderProgram(&program, "basic.frag", "basic.vert");
+    // Press P to switch to fetching the vertices in the vertex shader, where the driver supports it
+    Program pulledProgram;
+    if (IsVertexPullingSupported())
+    {
+        pulledProgram = LoadShaderProgramSpirvFile("basic.frag", "BasicPulled.vert");
+        WatchShaderProgram(&pulledProgram, "basic.frag", "BasicPulled.vert");
+    }
+    bool vertexPulling = false;
+    Program sceneProgram;
+    if (drawScene)
+    {
+        sceneProgram = LoadShaderProgramSpirvFile("basic.frag", "BasicGltf.vert");
+        WatchShaderProgram(&sceneProgram, "basic.frag", "BasicGltf.vert");
+    }
+    // Our "MVP" uniform is declared at location 0 in every vertex shader. Programs built from SPIR-V need
+    // not report names, so it can't be looked up by one
+    const GLint MVPLocation = 0;
 
     // Model matrix : an identity matrix (model will be at the origin)
     mat4 Model = translate(mat4(1.0), vec3(2, 0, 0)) * rotate(mat4(1.0), 3.14f / 2, vec3(0, 0, 1)) * scale(mat4(1.0), vec3(0.5, 0.5, 0.5));  // Changes for each model !
@@ -159,6 +220,8 @@ int main(int, char**)
         0.1f,        // Near clipping plane. Keep as big as possible, or you'll get precision issues.
         100.0f       // Far clipping plane. Keep as little as possible.
         );
+    // Levels of detail are picked so their error stays under a pixel with this field of view and window
+    float lodProjectionScale = LodProjectionScale(3.14f / 4, (float)WINDOW_HEIGHT);
 
     SDL_Event event;
     clock_t lastCall = clock();
@@ -171,6 +234,10 @@ int main(int, char**)
         float deltaTime = ((float)(thisCall - lastCall)) / (float)CLOCKS_PER_SEC;
         lastCall = thisCall;
 
+        // Hand over anything the loader finished since last frame, then swap in any rebuilt shaders
+        pumpAsyncLoads();
+        UpdateShaderReloads();
+
         // Direction : Spherical coordinates to Cartesian coordinates conversion
         glm::vec3 direction(
             cos(verticalAngle) * sin(horizontalAngle),
@@ -211,23 +278,81 @@ int main(int, char**)
 
         // Make our Model View Projection matrix
         mat4 MVP = Projection * View * Model;
+        if (quantized)
+            MVP = MVP * Dequantize;
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glUseProgram(programID);
+        // Meshlet and level of detail bounds are in model space, so the camera goes there too
+        vec3 modelCameraPosition = vec3(inverse(Model) * vec4(position, 1.0f));
+        if (meshlets && !drawScene && !drawBinaryMesh)
+            CullMeshlets(meshletCuller, MVP, modelCameraPosition);
+
+        // Switching level only rewrites the draw command, to the level's range of the element buffer
+        size_t lod = SelectMeshLod(lods, modelCameraPosition, lodProjectionScale);
+        if (lod != currentLod)
+        {
+            currentLod = lod;
+            elementsCommand.count = lodRanges[lod].count;
+            elementsCommand.firstIndex = lodRanges[lod].firstIndex;
+            glNamedBufferSubData(elementCommandBuffer.get(), 0, sizeof(DrawElementsIndirectCommand), &elementsCommand);
+        }
+
+        const Program& activeProgram = drawScene ? sceneProgram : vertexPulling && !drawBinaryMesh ? pulledProgram : program;
+        glUseProgram(activeProgram.get());
         // Send our transformation to the currently bound shader
-        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-        glBindVertexArray(VertexArrayID);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
-        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, elementCommandBuffer);
-        glMultiDrawElementsIndirect(
-            GL_TRIANGLES,                        // type of primitive to render
-            GL_UNSIGNED_INT,                     // data type in the GL_ELEMENT_ARRAY_BUFFER
-            0,                                   // offset in the GL_DRAW_INDIRECT_BUFFER to start at
-            1,                                   // how many commands to draw from the GL_DRAW_INDIRECT_BUFFER
-            sizeof(DrawElementsIndirectCommand)  // relative offset in the GL_DRAW_INDIRECT_BUFFER between command structures
-        );
+        glUniformMatrix4fv(MVPLocation, 1, GL_FALSE, &MVP[0][0]);
+
+        if (drawScene)
+        {
+            // Only the draws the camera can see are submitted. The scene's bounds and occluders are in its own
+            // space, as the shader's positions are, so Model goes into the matrix they are looked at through
+            CullGltfScene(scene, Projection * View * Model);
+            DrawGltfScene(scene);
+        }
+        else if (drawBinaryMesh)
+        {
+            DrawMesh<ObjVertexLayout>(binaryMesh);
+        }
+        else
+        {
+            if (vertexPulling)
+            {
+                // The vertex shader reads the vertex buffer itself, so there is no format to set up
+                BindVertexPulling(vertexBuffer.get(), pullingDrawBuffer.get(), elementBuffer.get());
+            }
+            else if (quantized)
+            {
+                // Same shader: GL unpacks the 16 bit positions and packed normals as it fetches them
+                BindVertexLayout<QuantizedVertexLayout>(quantizedVertexBuffer.get(), 0, elementBuffer.get());
+            }
+            else if (meshlets)
+            {
+                BindVertexLayout<ObjVertexLayout>(vertexBuffer.get(), 0, meshletElementBuffer.get());
+            }
+            else
+            {
+                // The attributes, their formats and the stride all come from ObjVertexLayout; the vertex array
+                // is shared with anything else of that format, and only rebound when the buffers change
+                BindVertexLayout<ObjVertexLayout>(vertexBuffer.get(), 0, elementBuffer.get());
+            }
+            if (meshlets)
+            {
+                // One command per meshlet that survived culling
+                DrawMeshlets(meshletCuller, meshletIndexData.type);
+            }
+            else
+            {
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, elementCommandBuffer.get());
+                glMultiDrawElementsIndirect(
+                    indexData.mode,                      // type of primitive to render
+                    indexData.type,                      // data type in the GL_ELEMENT_ARRAY_BUFFER
+                    0,                                   // offset in the GL_DRAW_INDIRECT_BUFFER to start at
+                    1,                                   // how many commands to draw from the GL_DRAW_INDIRECT_BUFFER
+                    sizeof(DrawElementsIndirectCommand)  // relative offset in the GL_DRAW_INDIRECT_BUFFER between command structures
+                );
+            }
+        }
         err_checkGL("Triangle via glDrawArraysIndirect");
 
         SDL_GL_SwapWindow(window.get());
@@ -259,6 +384,39 @@ int main(int, char**)
                 case SDLK_DOWN:
                     downKey = event.type == SDL_KEYDOWN;
                     break;
+                case SDLK_p:
+                    if (event.type == SDL_KEYDOWN && pulledProgram)
+                    {
+                        vertexPulling = !vertexPulling;
+                        quantized = false;
+                        meshlets = false;
+                    }
+                    break;
+                case SDLK_q:
+                    if (event.type == SDL_KEYDOWN && !drawScene && !drawBinaryMesh)
+                    {
+                        quantized = !quantized;
+                        vertexPulling = false;
+                        meshlets = false;
+                    }
+                    break;
+                case SDLK_m:
+                    if (event.type == SDL_KEYDOWN && !drawScene && !drawBinaryMesh)
+                    {
+                        meshlets = !meshlets;
+                        vertexPulling = false;
+                        quantized = false;
+                    }
+                    break;
+                case SDLK_o:
+                    if (event.type == SDL_KEYDOWN && drawScene)
+                    {
+                        if (scene.occlusion.levels.empty())
+                            ResizeOcclusionBuffer(scene.occlusion, WINDOW_WIDTH / 4, WINDOW_HEIGHT / 4);
+                        else
+                            scene.occlusion = OcclusionBuffer();
+                    }
+                    break;
                 default: break;
                 }
                 break;
@@ -276,6 +434,7 @@ int main(int, char**)
             }
         }
     }
-    
+
+    ClearVertexArrayCache();
     return 0;
 }
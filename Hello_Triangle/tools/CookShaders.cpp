@@ -0,0 +1,73 @@
+// Offline shader cook.
+// Usage: CookShaders <output directory> <data directory> <shader path>...
+// Runs each shader through the same preprocessor the runtime uses, so #includes are expanded at build
+// time, and writes the result under the output directory with the same relative path. Fails if any
+// include cannot be resolved. The cooked shaders are what gets packed into data.pak and compiled to SPIR-V.
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "../src/ShaderPreprocessor.h"
+
+static std::string dataDirectory;
+
+static bool ReadWholeFile(const std::string& filePath, std::string& contents)
+{
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (file == nullptr) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    contents.resize(size > 0 ? (size_t)size : 0);
+    bool ok = size >= 0 && fread(&contents[0], 1, contents.size(), file) == contents.size();
+    fclose(file);
+    return ok;
+}
+
+// The preprocessor reads includes through this; at build time they come straight from the data directory
+static bool LoadDataFile(const char* filePath, std::string& contents)
+{
+    return ReadWholeFile(dataDirectory + filePath, contents);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <output directory> <data directory> <shader path>...\n", argv[0]);
+        return 1;
+    }
+
+    std::string outputDirectory = std::string(argv[1]) + "/";
+    dataDirectory = std::string(argv[2]) + "/";
+    bool ok = true;
+    for (int i = 3; i < argc; ++i)
+    {
+        std::string source;
+        if (!LoadDataFile(argv[i], source))
+        {
+            fprintf(stderr, "Error: unable to read %s%s\n", dataDirectory.c_str(), argv[i]);
+            ok = false;
+            continue;
+        }
+
+        std::string errors;
+        std::string cooked = PreprocessShaderSource(source.c_str(), LoadDataFile, std::vector<std::string>(), &errors);
+        if (!errors.empty())
+        {
+            fprintf(stderr, "%s%s: error: %s", dataDirectory.c_str(), argv[i], errors.c_str());
+            ok = false;
+            continue;
+        }
+
+        std::string outputPath = outputDirectory + argv[i];
+        FILE* output = fopen(outputPath.c_str(), "wb");
+        if (output == nullptr || fwrite(cooked.data(), 1, cooked.size(), output) != cooked.size())
+        {
+            fprintf(stderr, "Error: unable to write %s\n", outputPath.c_str());
+            ok = false;
+        }
+        if (output != nullptr && fclose(output) != 0)
+            ok = false;
+    }
+    return ok ? 0 : 1;
+}
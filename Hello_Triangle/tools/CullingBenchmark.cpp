@@ -0,0 +1,111 @@
+// Measures CPU frustum culling throughput.
+// Usage: CullingBenchmark [objects] [runs]
+// Objects are boxes and spheres of random sizes scattered through a cube 2000 units across, seen by the
+// tutorial's projection from the middle; each result is checked against a plain one object at a time cull.
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../src/FrustumCulling.h"
+#include "../src/SimdLanes.h"
+#include "../src/WorkerPool.h"
+
+// Best of several runs, in milliseconds
+template <typename Cull>
+static double TimeCull(int runs, Cull cull)
+{
+    double best = 1e30;
+    for (int run = 0; run < runs; ++run)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        cull();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+static bool ReferenceAabbVisible(const Frustum& frustum, const CullingAabbs& bounds, size_t i)
+{
+    for (const glm::vec4& plane : frustum.planes)
+    {
+        float distance = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w;
+        float reach = fabsf(plane.x) * bounds.extentX[i] + fabsf(plane.y) * bounds.extentY[i] + fabsf(plane.z) * bounds.extentZ[i];
+        if (distance + reach < 0.0f) return false;
+    }
+    return true;
+}
+
+static bool ReferenceSphereVisible(const Frustum& frustum, const CullingSpheres& bounds, size_t i)
+{
+    for (const glm::vec4& plane : frustum.planes)
+        if (plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w + bounds.radius[i] < 0.0f)
+            return false;
+    return true;
+}
+
+template <typename Visible>
+static bool Check(const std::vector<uint32_t>& visible, size_t count, Visible reference)
+{
+    size_t next = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!reference(i)) continue;
+        if (next >= visible.size() || visible[next] != i) return false;
+        ++next;
+    }
+    return next == visible.size();
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? (size_t)atol(argv[1]) : 1 << 20;
+    int runs = argc > 2 ? atoi(argv[2]) : 50;
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> place(-1000.0f, 1000.0f), size(0.5f, 10.0f);
+    CullingAabbs boxes;
+    CullingSpheres spheres;
+    ResizeCullingBounds(boxes, count);
+    ResizeCullingBounds(spheres, count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::vec3 center(place(random), place(random), place(random));
+        glm::vec3 extent(size(random), size(random), size(random));
+        SetCullingAabb(boxes, i, center - extent, center + extent);
+        SetCullingSphere(spheres, i, center, size(random));
+    }
+
+    glm::mat4 projection = glm::perspective(3.14f / 4, 4.0f / 3.0f, 0.1f, 1000.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(0.3f, 0.1f, -1.0f), glm::vec3(0, 1, 0));
+    Frustum frustum = ExtractFrustum(projection * view);
+
+    printf("%u objects, %u threads, %d wide SIMD\n", (unsigned)count, WorkerThreadCount(), SIMD_LANES);
+
+    std::vector<uint32_t> visible;
+    bool ok = true;
+    double boxesSerial = TimeCull(runs, [&] { CullAabbs(frustum, boxes, visible, false); });
+    ok &= Check(visible, count, [&](size_t i) { return ReferenceAabbVisible(frustum, boxes, i); });
+    double boxesParallel = TimeCull(runs, [&] { CullAabbs(frustum, boxes, visible, true); });
+    ok &= Check(visible, count, [&](size_t i) { return ReferenceAabbVisible(frustum, boxes, i); });
+    printf("  boxes:   %8u visible, %8.3f ms on one thread, %8.3f ms on all\n", (unsigned)visible.size(), boxesSerial, boxesParallel);
+
+    double spheresSerial = TimeCull(runs, [&] { CullSpheres(frustum, spheres, visible, false); });
+    ok &= Check(visible, count, [&](size_t i) { return ReferenceSphereVisible(frustum, spheres, i); });
+    double spheresParallel = TimeCull(runs, [&] { CullSpheres(frustum, spheres, visible, true); });
+    ok &= Check(visible, count, [&](size_t i) { return ReferenceSphereVisible(frustum, spheres, i); });
+    printf("  spheres: %8u visible, %8.3f ms on one thread, %8.3f ms on all\n", (unsigned)visible.size(), spheresSerial, spheresParallel);
+
+    if (!ok)
+    {
+        fprintf(stderr, "Culling results differ from the reference\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+#ifndef __MeshWriter_h__
+#define __MeshWriter_h__
+// Writes binary meshes (see src/MeshFormat.h) for the offline tools.
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "../src/MeshFormat.h"
+
+// One stream's contents, exactly as they should end up in the GL buffer
+struct MeshStreamData
+{
+    uint32_t kind;       // MESH_STREAM_VERTEX or MESH_STREAM_INDEX
+    uint32_t stride;     // bytes per vertex, or per index
+    uint64_t layoutHash; // VertexLayout::hash for vertex streams
+    std::vector<char> bytes;
+};
+
+inline bool WriteMeshFile(const char* filePath, const std::vector<MeshStreamData>& streams, const std::vector<MeshDraw>& draws)
+{
+    FILE* output = fopen(filePath, "wb");
+    if (output == nullptr) return false;
+
+    MeshHeader header;
+    memcpy(header.magic, MESH_MAGIC, 4);
+    header.version = MESH_VERSION;
+    header.streamCount = (uint32_t)streams.size();
+    header.drawCount = (uint32_t)draws.size();
+
+    // Lay the streams out after the tables, each one aligned
+    std::vector<MeshStream> table(streams.size());
+    uint64_t offset = sizeof(MeshHeader) + streams.size() * sizeof(MeshStream) + draws.size() * sizeof(MeshDraw);
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+        offset = (offset + MESH_ALIGNMENT - 1) & ~(uint64_t)(MESH_ALIGNMENT - 1);
+        table[i].offset = offset;
+        table[i].size = streams[i].bytes.size();
+        table[i].layoutHash = streams[i].layoutHash;
+        table[i].kind = streams[i].kind;
+        table[i].stride = streams[i].stride;
+        offset += table[i].size;
+    }
+
+    fwrite(&header, sizeof(header), 1, output);
+    fwrite(table.data(), sizeof(MeshStream), table.size(), output);
+    fwrite(draws.data(), sizeof(MeshDraw), draws.size(), output);
+
+    static const char padding[MESH_ALIGNMENT] = {};
+    uint64_t written = sizeof(MeshHeader) + streams.size() * sizeof(MeshStream) + draws.size() * sizeof(MeshDraw);
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+        fwrite(padding, 1, (size_t)(table[i].offset - written), output);
+        fwrite(streams[i].bytes.data(), 1, streams[i].bytes.size(), output);
+        written = table[i].offset + table[i].size;
+    }
+
+    bool ok = ferror(output) == 0;
+    return fclose(output) == 0 && ok;
+}
+
+#endif
@@ -0,0 +1,108 @@
+// Measures OBJ import throughput.
+// Usage: ObjBenchmark [file.obj] [runs]
+// Without a file, a generated grid of about 50 MB is imported instead. Each run imports the whole text
+// from memory, so the numbers are parsing and deduplication alone; the file is read once up front.
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/MappedFile.h"
+#include "../src/ObjImporter.h"
+
+// A GRID x GRID sheet of quads with positions, uvs and normals, in the style exporters write
+static std::string GenerateObj(int grid)
+{
+    std::string obj;
+    char line[128];
+    for (int j = 0; j <= grid; ++j)
+    {
+        for (int i = 0; i <= grid; ++i)
+        {
+            snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\n", i * 0.01, j * 0.01, (i ^ j) * 0.001, i / (double)grid, j / (double)grid);
+            obj += line;
+        }
+    }
+    obj += "vn 0.000000 0.000000 1.000000\n";
+    for (int j = 0; j < grid; ++j)
+    {
+        for (int i = 0; i < grid; ++i)
+        {
+            int a = j * (grid + 1) + i + 1, b = a + 1, c = a + grid + 1, d = c + 1;
+            snprintf(line, sizeof(line), "f %d/%d/1 %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, b, b, d, d, c, c);
+            obj += line;
+        }
+    }
+    return obj;
+}
+
+// Best of several runs, in seconds
+static double TimeImport(const char* source, size_t size, unsigned threads, int runs, ObjMesh& mesh)
+{
+    double best = 1e30;
+    for (int run = 0; run < runs; ++run)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (!ImportObjSource(source, size, mesh, threads))
+        {
+            fprintf(stderr, "Import failed\n");
+            exit(1);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    int runs = argc > 2 ? atoi(argv[2]) : 5;
+
+    std::string generated;
+    const char* source;
+    size_t size = 0;
+    const unsigned char* mapped = nullptr;
+    if (argc > 1)
+    {
+        mapped = MapFile(argv[1], &size, true);
+        if (mapped == nullptr)
+        {
+            fprintf(stderr, "Unable to open %s\n", argv[1]);
+            return 1;
+        }
+        source = (const char*)mapped;
+        // Fault the whole file in before timing anything
+        volatile unsigned char touch = 0;
+        for (size_t i = 0; i < size; i += 4096) touch ^= mapped[i];
+    }
+    else
+    {
+        generated = GenerateObj(700);
+        source = generated.data();
+        size = generated.size();
+    }
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    ObjMesh mesh;
+    double megabytes = (double)size / (1024.0 * 1024.0);
+    printf("%.1f MB, best of %d runs\n", megabytes, runs);
+    printf("%8s %12s %12s\n", "threads", "ms", "MB/s");
+    // Powers of two below the core count, then every core
+    std::vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < cores; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(cores);
+    for (unsigned threads : threadCounts)
+    {
+        double seconds = TimeImport(source, size, threads, runs, mesh);
+        printf("%8u %12.2f %12.1f\n", threads, seconds * 1000.0, megabytes / seconds);
+    }
+    printf("%u vertices, %u triangles\n", (unsigned)mesh.vertices.size(), (unsigned)(mesh.indices.size() / 3));
+
+    if (mapped != nullptr)
+        UnmapFile(mapped, size);
+    return 0;
+}
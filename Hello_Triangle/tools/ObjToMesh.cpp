@@ -0,0 +1,67 @@
+// Offline OBJ to binary mesh converter.
+// Usage: ObjToMesh <input.obj> <output.mesh>
+// The vertices are written in ObjVertexLayout, as main uploads them after an import, and the indices as a
+// triangle list in the narrowest type that holds them. Loading the result with LoadMesh skips parsing
+// and deduplication altogether; the times printed are what the import costs at runtime.
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "../src/IndexBuffer.h"
+#include "../src/ObjImporter.h"
+#include "../src/VertexLayout.h"
+#include "MeshWriter.h"
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s <input.obj> <output.mesh>\n", argv[0]);
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ObjMesh mesh;
+    // ImportObj says what went wrong
+    if (!ImportObj(argv[1], mesh)) return 1;
+    std::chrono::duration<double, std::milli> importTime = std::chrono::steady_clock::now() - start;
+    if (mesh.vertices.empty() || mesh.indices.empty())
+    {
+        fprintf(stderr, "%s has no triangles\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<MeshStreamData> streams(2);
+    MeshStreamData& vertices = streams[0];
+    vertices.kind = MESH_STREAM_VERTEX;
+    vertices.stride = ObjVertexLayout::stride;
+    vertices.layoutHash = ObjVertexLayout::hash;
+    vertices.bytes.resize(mesh.vertices.size() * sizeof(ObjVertex));
+    memcpy(vertices.bytes.data(), mesh.vertices.data(), vertices.bytes.size());
+
+    // Lists only: a draw has no primitive mode to say it is made of strips
+    IndexData indexData;
+    BuildIndexData(mesh.indices.data(), mesh.indices.size(), false, indexData);
+    MeshStreamData& indices = streams[1];
+    indices.kind = MESH_STREAM_INDEX;
+    indices.stride = (uint32_t)IndexTypeSize(indexData.type);
+    indices.layoutHash = 0;
+    indices.bytes.assign(indexData.bytes.begin(), indexData.bytes.end());
+
+    MeshDraw draw = {};
+    draw.vertexStream = 0;
+    draw.indexStream = 1;
+    draw.firstIndex = 0;
+    draw.indexCount = indexData.count;
+    draw.baseVertex = 0;
+
+    if (!WriteMeshFile(argv[2], streams, std::vector<MeshDraw>(1, draw)))
+    {
+        fprintf(stderr, "Unable to write %s\n", argv[2]);
+        return 1;
+    }
+    printf("%s: %u vertices, %u triangles, %u byte indices, imported in %.1f ms\n", argv[2], (unsigned)mesh.vertices.size(),
+        (unsigned)(mesh.indices.size() / 3), indices.stride, importTime.count());
+    return 0;
+}
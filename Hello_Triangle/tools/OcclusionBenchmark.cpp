@@ -0,0 +1,153 @@
+// Measures CPU occlusion culling: rasterizing occluders and testing boxes against them.
+// Usage: OcclusionBenchmark [objects] [runs]
+// A grid of city blocks stands on a ground plane, seen from street level; the blocks are the occluders and
+// the objects are small boxes scattered over the ground between and behind them. Results are checked
+// against a scan of every covered pixel, and the parallel passes against the serial ones.
+#include <algorithm>
+#include <chrono>
+#include <float.h>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../src/FrustumCulling.h"
+#include "../src/OcclusionCulling.h"
+#include "../src/SimdLanes.h"
+#include "../src/WorkerPool.h"
+
+// Best of several runs, in milliseconds
+template <typename Run>
+static double Time(int runs, Run run)
+{
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+static void AddBox(std::vector<float>& positions, std::vector<uint32_t>& indices, const glm::vec3& low, const glm::vec3& high)
+{
+    static const uint32_t faces[36] = {
+        0, 2, 1, 1, 2, 3,  4, 5, 6, 5, 7, 6,  0, 1, 4, 1, 5, 4,
+        2, 6, 3, 3, 6, 7,  0, 4, 2, 2, 4, 6,  1, 3, 5, 3, 7, 5
+    };
+    uint32_t first = (uint32_t)(positions.size() / 3);
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        positions.push_back(corner & 1 ? high.x : low.x);
+        positions.push_back(corner & 2 ? high.y : low.y);
+        positions.push_back(corner & 4 ? high.z : low.z);
+    }
+    for (uint32_t index : faces)
+        indices.push_back(first + index);
+}
+
+// Whether every pixel the box covers holds something nearer, without the levels
+static bool ReferenceOccluded(const OcclusionBuffer& buffer, const glm::vec3& low, const glm::vec3& high)
+{
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearest = FLT_MAX;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        glm::vec4 p = buffer.viewProjection * glm::vec4(corner & 1 ? high.x : low.x, corner & 2 ? high.y : low.y, corner & 4 ? high.z : low.z, 1.0f);
+        if (p.z < -p.w) return false;
+        float inverseW = 1.0f / p.w;
+        float x = (p.x * inverseW * 0.5f + 0.5f) * (float)buffer.width;
+        float y = (p.y * inverseW * 0.5f + 0.5f) * (float)buffer.height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        nearest = std::min(nearest, p.z * inverseW * 0.5f + 0.5f);
+    }
+    const OcclusionLevel& pixels = buffer.levels[0];
+    for (int y = std::max((int)floorf(std::max(minY, 0.0f)), 0); y <= std::min((int)floorf(std::min(maxY, (float)buffer.height)), buffer.height - 1); ++y)
+        for (int x = std::max((int)floorf(std::max(minX, 0.0f)), 0); x <= std::min((int)floorf(std::min(maxX, (float)buffer.width)), buffer.width - 1); ++x)
+            if (pixels.depth[(size_t)y * pixels.width + x] >= nearest)
+                return false;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? (size_t)atol(argv[1]) : 100000;
+    int runs = argc > 2 ? atoi(argv[2]) : 50;
+
+    // 16 x 16 blocks 40 units across with 20 unit streets between them
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+    AddBox(positions, indices, glm::vec3(-500.0f, -1.0f, -500.0f), glm::vec3(500.0f, 0.0f, 500.0f));
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> storeys(10.0f, 80.0f);
+    for (int row = 0; row < 16; ++row)
+        for (int column = 0; column < 16; ++column)
+        {
+            glm::vec3 low(-480.0f + column * 60.0f, 0.0f, -480.0f + row * 60.0f);
+            AddBox(positions, indices, low, low + glm::vec3(40.0f, storeys(random), 40.0f));
+        }
+
+    std::uniform_real_distribution<float> place(-500.0f, 500.0f), size(0.5f, 3.0f);
+    CullingAabbs boxes;
+    ResizeCullingBounds(boxes, count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::vec3 low(place(random), 0.0f, place(random));
+        SetCullingAabb(boxes, i, low, low + glm::vec3(size(random), size(random), size(random)));
+    }
+
+    // At the end of a street, looking down it
+    glm::mat4 projection = glm::perspective(3.14f / 4, 4.0f / 3.0f, 0.1f, 1000.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(-430.0f, 2.0f, 490.0f), glm::vec3(-430.0f, 2.0f, 0.0f), glm::vec3(0, 1, 0));
+    glm::mat4 viewProjection = projection * view;
+
+    OcclusionBuffer buffer;
+    ResizeOcclusionBuffer(buffer, 160, 120);
+    printf("%u occluder triangles, %dx%d pixels, %u objects, %u threads, %d wide SIMD\n", (unsigned)(indices.size() / 3),
+        buffer.width, buffer.height, (unsigned)count, WorkerThreadCount(), SIMD_LANES);
+
+    double setup = Time(runs, [&] {
+        BeginOcclusionFrame(buffer, viewProjection);
+        AddOccluder(buffer, glm::mat4(1.0f), positions.data(), positions.size() / 3, 3 * sizeof(float), indices.data(), indices.size());
+    });
+    double rasterSerial = Time(runs, [&] { RasterizeOccluders(buffer, false); });
+    std::vector<float> serialDepth = buffer.levels[0].depth;
+    double rasterParallel = Time(runs, [&] { RasterizeOccluders(buffer, true); });
+    bool ok = serialDepth == buffer.levels[0].depth;
+    printf("  occluders: %u triangles after clipping, %8.3f ms to clip, %8.3f ms to rasterize on one thread, %8.3f ms on all\n",
+        (unsigned)buffer.triangles.size(), setup, rasterSerial, rasterParallel);
+
+    std::vector<uint32_t> inFrustum, visible;
+    CullAabbs(ExtractFrustum(viewProjection), boxes, inFrustum);
+    double testSerial = Time(runs, [&] { visible = inFrustum; CullOccludedAabbs(buffer, boxes, visible, false); });
+    std::vector<uint32_t> serialVisible = visible;
+    double testParallel = Time(runs, [&] { visible = inFrustum; CullOccludedAabbs(buffer, boxes, visible, true); });
+    ok &= serialVisible == visible;
+    printf("  objects:   %u in the frustum, %u not occluded, %8.3f ms to test on one thread, %8.3f ms on all\n",
+        (unsigned)inFrustum.size(), (unsigned)visible.size(), testSerial, testParallel);
+
+    size_t next = 0;
+    for (uint32_t object : inFrustum)
+    {
+        glm::vec3 center(boxes.centerX[object], boxes.centerY[object], boxes.centerZ[object]);
+        glm::vec3 extent(boxes.extentX[object], boxes.extentY[object], boxes.extentZ[object]);
+        bool kept = next < visible.size() && visible[next] == object;
+        if (kept) ++next;
+        if (kept == ReferenceOccluded(buffer, center - extent, center + extent))
+            ok = false;
+    }
+
+    if (!ok)
+    {
+        fprintf(stderr, "Occlusion results differ from the reference\n");
+        return 1;
+    }
+    return 0;
+}
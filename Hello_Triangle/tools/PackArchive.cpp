@@ -0,0 +1,117 @@
+// Offline asset packer.
+// Usage: PackArchive <output.pak> <data directory> <asset path>... [-C <directory> <asset path>...]...
+// Asset paths are relative to the data directory and are what loadFile will be asked for at runtime.
+// -C switches the directory the following asset paths are read from, so built assets (cooked shaders)
+// can be packed under the same names as the sources they were built from.
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "../src/ArchiveFormat.h"
+
+struct Asset
+{
+    std::string path;
+    std::vector<char> contents;
+    ArchiveEntry entry;
+};
+
+static bool ReadWholeFile(const std::string& filePath, std::vector<char>& contents)
+{
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (file == nullptr) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    contents.resize(size > 0 ? (size_t)size : 0);
+    bool ok = size >= 0 && fread(contents.data(), 1, contents.size(), file) == contents.size();
+    fclose(file);
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <output.pak> <data directory> <asset path>... [-C <directory> <asset path>...]...\n", argv[0]);
+        return 1;
+    }
+
+    std::string dataDirectory = std::string(argv[2]) + "/";
+    std::vector<Asset> assets;
+    for (int i = 3; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-C") == 0 && i + 1 < argc)
+        {
+            dataDirectory = std::string(argv[++i]) + "/";
+            continue;
+        }
+
+        assets.emplace_back();
+        Asset& asset = assets.back();
+        asset.path = argv[i];
+        asset.entry.hash = ArchiveHashPath(argv[i]);
+        if (!ReadWholeFile(dataDirectory + asset.path, asset.contents))
+        {
+            fprintf(stderr, "Error: unable to read %s%s\n", dataDirectory.c_str(), argv[i]);
+            return 1;
+        }
+    }
+
+    std::sort(assets.begin(), assets.end(),
+        [](const Asset& a, const Asset& b) { return a.entry.hash < b.entry.hash; });
+    for (size_t i = 1; i < assets.size(); ++i)
+    {
+        if (assets[i - 1].entry.hash == assets[i].entry.hash)
+        {
+            fprintf(stderr, "Error: %s and %s have the same hash\n", assets[i - 1].path.c_str(), assets[i].path.c_str());
+            return 1;
+        }
+    }
+
+    // Lay the blobs out after the index, each one aligned
+    uint64_t offset = sizeof(ArchiveHeader) + assets.size() * sizeof(ArchiveEntry);
+    for (Asset& asset : assets)
+    {
+        offset = (offset + ARCHIVE_ALIGNMENT - 1) & ~(uint64_t)(ARCHIVE_ALIGNMENT - 1);
+        asset.entry.offset = offset;
+        asset.entry.size = asset.contents.size();
+        offset += asset.entry.size;
+    }
+
+    FILE* output = fopen(argv[1], "wb");
+    if (output == nullptr)
+    {
+        fprintf(stderr, "Error: unable to open %s for writing\n", argv[1]);
+        return 1;
+    }
+
+    ArchiveHeader header;
+    memcpy(header.magic, ARCHIVE_MAGIC, 4);
+    header.version = ARCHIVE_VERSION;
+    header.entryCount = (uint32_t)assets.size();
+    header.alignment = ARCHIVE_ALIGNMENT;
+    fwrite(&header, sizeof(header), 1, output);
+    for (const Asset& asset : assets)
+        fwrite(&asset.entry, sizeof(ArchiveEntry), 1, output);
+
+    static const char padding[ARCHIVE_ALIGNMENT] = {};
+    uint64_t written = sizeof(ArchiveHeader) + assets.size() * sizeof(ArchiveEntry);
+    for (const Asset& asset : assets)
+    {
+        fwrite(padding, 1, (size_t)(asset.entry.offset - written), output);
+        fwrite(asset.contents.data(), 1, asset.contents.size(), output);
+        written = asset.entry.offset + asset.entry.size;
+    }
+
+    bool ok = ferror(output) == 0;
+    ok = fclose(output) == 0 && ok;
+    if (!ok)
+    {
+        fprintf(stderr, "Error: failed writing %s\n", argv[1]);
+        return 1;
+    }
+    printf("Packed %u assets into %s\n", header.entryCount, argv[1]);
+    return 0;
+}
@@ -0,0 +1,162 @@
+// Compares monolithic programs against separable programs mixed in program pipelines.
+// Usage: PipelineBenchmark [vertex shader count] [fragment shader count] [passes]
+// Every vertex shader is paired with every fragment shader. Monolithic programs need a link per pair;
+// separable programs need a link per shader plus a pipeline object per pair. Compiles go through the
+// shader cache, which is emptied between the two, so each side compiles every source exactly once and
+// the difference in build time is what the links and pipeline objects cost.
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <SDL.h>
+
+#include "../src/ErrorHandling.h"
+#include "../src/ProgramPipeline.h"
+#include "../src/ShaderLoader.h"
+
+static std::string VertexSource(int i)
+{
+    return "#version 450 core\n"
+        "layout(location = 0) in vec3 vertexPosition_modelspace;\n"
+        "layout(location = 0) out vec3 color;\n"
+        "out gl_PerVertex { vec4 gl_Position; float gl_PointSize; };\n"
+        "void main(){\n"
+        "    gl_Position = vec4(vertexPosition_modelspace * " + std::to_string(i + 1) + ".0, 1);\n"
+        "    gl_PointSize = 1.0;\n"
+        "    color = vec3(" + std::to_string(i) + ".0);\n"
+        "}\n";
+}
+
+static std::string FragmentSource(int i)
+{
+    return "#version 450 core\n"
+        "layout(location = 0) in vec3 color;\n"
+        "out vec3 fragColor;\n"
+        "void main(){\n"
+        "    fragColor = color * " + std::to_string(i + 1) + ".0;\n"
+        "}\n";
+}
+
+static double Seconds(Uint64 start, Uint64 end)
+{
+    return (double)(end - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+#ifdef _WIN32
+int wmain(int argc, char** argv)
+#else
+int main(int argc, char** argv)
+#endif
+{
+    int vertexCount = argc > 1 ? atoi(argv[1]) : 8;
+    int fragmentCount = argc > 2 ? atoi(argv[2]) : 8;
+    int passes = argc > 3 ? atoi(argv[3]) : 100;
+
+    SDL_Init(SDL_INIT_VIDEO);
+    err_checkSDL("Unable to init SDL video");
+    atexit(SDL_Quit);
+
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, 1);
+
+    std::unique_ptr<SDL_Window, void(*)(SDL_Window *)> window(
+        SDL_CreateWindow("Pipeline Benchmark", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 64, 64, SDL_WINDOW_HIDDEN | SDL_WINDOW_OPENGL),
+        SDL_DestroyWindow);
+    err_checkSDL("Unable to open SDL window");
+
+    std::unique_ptr<void, void(*)(void *)> context(
+        SDL_GL_CreateContext(window.get()),
+        SDL_GL_DeleteContext);
+    err_checkSDL("Unable to create OpenGL context");
+
+    glewExperimental = true; // Needed in core profile
+    GLenum glerr = glewInit();
+    if (glerr != GLEW_OK)
+        err_fatalf("Failed to initialize GLEW: %s", glewGetErrorString(glerr));
+    else if (!GLEW_VERSION_4_5)
+        err_fatalf("Failed to initialize GLEW: OpenGL 4.5 extensions not supported/loaded");
+    err_clearGL();
+
+    std::vector<std::string> vertexSources, fragmentSources;
+    for (int i = 0; i < vertexCount; ++i) vertexSources.push_back(VertexSource(i));
+    for (int i = 0; i < fragmentCount; ++i) fragmentSources.push_back(FragmentSource(i));
+
+    // Nothing is read from buffers; the draws only exist to make the driver validate each binding
+    VertexArray vertexArray = CreateVertexArray();
+    glBindVertexArray(vertexArray.get());
+
+    // Monolithic: one link per combination
+    glFinish();
+    Uint64 start = SDL_GetPerformanceCounter();
+    std::vector<Program> programs;
+    for (int v = 0; v < vertexCount; ++v)
+        for (int f = 0; f < fragmentCount; ++f)
+            programs.push_back(LoadShaderProgramSource(fragmentSources[f].c_str(), vertexSources[v].c_str()));
+    glFinish();
+    double monolithicBuild = Seconds(start, SDL_GetPerformanceCounter());
+
+    start = SDL_GetPerformanceCounter();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (const Program& program : programs)
+        {
+            glUseProgram(program.get());
+            glDrawArrays(GL_POINTS, 0, 1);
+        }
+    }
+    glFinish();
+    double monolithicBind = Seconds(start, SDL_GetPerformanceCounter());
+    glUseProgram(0);
+    err_checkGL("Monolithic programs");
+    // Deleting the programs releases their shaders, so the separable build compiles them again too
+    programs.clear();
+
+    // Separable: one link per stage, and a pipeline per combination
+    glFinish();
+    start = SDL_GetPerformanceCounter();
+    std::vector<Program> vertexPrograms, fragmentPrograms;
+    std::vector<GLuint> pipelines;
+    for (int v = 0; v < vertexCount; ++v)
+        vertexPrograms.push_back(LoadSeparableShaderProgramSource(vertexSources[v].c_str(), GL_VERTEX_SHADER));
+    for (int f = 0; f < fragmentCount; ++f)
+        fragmentPrograms.push_back(LoadSeparableShaderProgramSource(fragmentSources[f].c_str(), GL_FRAGMENT_SHADER));
+    for (const Program& vertexProgram : vertexPrograms)
+        for (const Program& fragmentProgram : fragmentPrograms)
+            pipelines.push_back(GetProgramPipeline(vertexProgram.get(), fragmentProgram.get()));
+    glFinish();
+    double separableBuild = Seconds(start, SDL_GetPerformanceCounter());
+
+    start = SDL_GetPerformanceCounter();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (GLuint pipeline : pipelines)
+        {
+            glBindProgramPipeline(pipeline);
+            glDrawArrays(GL_POINTS, 0, 1);
+        }
+    }
+    glFinish();
+    double separableBind = Seconds(start, SDL_GetPerformanceCounter());
+    glBindProgramPipeline(0);
+    err_checkGL("Separable programs");
+
+    int combinations = vertexCount * fragmentCount;
+    int binds = combinations * passes;
+    ShaderCacheStats stats = GetShaderCacheStats();
+    printf("%d vertex x %d fragment shaders, %d binds each way\n", vertexCount, fragmentCount, binds);
+    printf("%u shaders compiled, %u compiles avoided by the shader cache\n", stats.compiles, stats.compilesAvoided);
+    printf("%-12s %8s %14s %16s\n", "", "links", "build (ms)", "bind+draw (us)");
+    printf("%-12s %8d %14.3f %16.3f\n", "monolithic", combinations, monolithicBuild * 1000.0, monolithicBind * 1e6 / binds);
+    printf("%-12s %8d %14.3f %16.3f\n", "separable", vertexCount + fragmentCount, separableBuild * 1000.0, separableBind * 1e6 / binds);
+
+    // Clean up while the context is still current
+    vertexPrograms.clear();
+    fragmentPrograms.clear();
+    vertexArray.reset();
+    return 0;
+}
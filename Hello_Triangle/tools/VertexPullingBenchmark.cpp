@@ -0,0 +1,294 @@
+// Compares drawing through vertex arrays against vertex pulling from storage buffers.
+// Usage: VertexPullingBenchmark [mesh count] [passes]
+// Meshes alternate between three vertex formats and all live in one vertex buffer and one index buffer.
+// The vertex array path needs a draw per mesh, or at best a multi-draw per format with the vertex array
+// switched in between; the pulled path draws every mesh, whatever its format, in one multi-draw.
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <SDL.h>
+
+#include "../src/DrawCommands.h"
+#include "../src/ErrorHandling.h"
+#include "../src/GLObjects.h"
+#include "../src/ShaderLoader.h"
+#include "../src/VertexArrayCache.h"
+#include "../src/VertexLayout.h"
+#include "../src/VertexPulling.h"
+
+using namespace glm;
+
+struct PositionVertex
+{
+    vec3 position;
+};
+struct LitVertex
+{
+    vec3 normal;
+    vec3 position;
+};
+struct TexturedVertex
+{
+    vec2 uv;
+    vec3 position;
+    u8vec4 color;
+};
+
+typedef VertexLayout<PositionVertex,
+    VERTEX_ATTRIBUTE(0, PositionVertex, position)> PositionLayout;
+typedef VertexLayout<LitVertex,
+    VERTEX_ATTRIBUTE(0, LitVertex, position),
+    VERTEX_ATTRIBUTE(1, LitVertex, normal)> LitLayout;
+typedef VertexLayout<TexturedVertex,
+    VERTEX_ATTRIBUTE(0, TexturedVertex, position),
+    VERTEX_ATTRIBUTE(1, TexturedVertex, uv),
+    VERTEX_ATTRIBUTE(2, TexturedVertex, color)> TexturedLayout;
+
+const int FORMAT_COUNT = 3;
+const int GRID = 8; // vertices along each side of a mesh
+
+static const char* attributeVertexSource =
+    "#version 450 core\n"
+    "layout(location = 0) in vec3 vertexPosition_modelspace;\n"
+    "void main(){\n"
+    "    gl_Position = vec4(vertexPosition_modelspace * 0.01, 1);\n"
+    "}\n";
+
+static const char* pulledVertexSource =
+    "#version 450 core\n"
+    "#extension GL_ARB_shader_draw_parameters : require\n"
+    "struct PulledDraw { uint firstWord; uint strideWords; uint positionWord; uint padding; };\n"
+    "layout(std430, binding = 0) readonly buffer PulledVertices { float vertexWords[]; };\n"
+    "layout(std430, binding = 1) readonly buffer PulledDraws { PulledDraw draws[]; };\n"
+    "void main(){\n"
+    "    PulledDraw draw = draws[gl_DrawIDARB];\n"
+    "    uint word = draw.firstWord + uint(gl_VertexID) * draw.strideWords + draw.positionWord;\n"
+    "    gl_Position = vec4(vec3(vertexWords[word], vertexWords[word + 1], vertexWords[word + 2]) * 0.01, 1);\n"
+    "}\n";
+
+static const char* fragmentSource =
+    "#version 450 core\n"
+    "out vec3 fragColor;\n"
+    "void main(){\n"
+    "    fragColor = vec3(1);\n"
+    "}\n";
+
+// Where a mesh ended up in the shared buffers
+struct Mesh
+{
+    int format;
+    GLintptr firstByte; // of its first vertex in the vertex buffer
+    GLuint firstVertex; // counted in vertices of its format from the start of the format's region
+    GLuint firstIndex;
+};
+
+// Append a grid of GRID x GRID vertices in one format; positions are the only thing the shaders read
+template <typename Vertex>
+static void AppendVertices(std::vector<char>& vertexData, float x, float y)
+{
+    for (int j = 0; j < GRID; ++j)
+    {
+        for (int i = 0; i < GRID; ++i)
+        {
+            Vertex vertex = Vertex();
+            vertex.position = vec3(x + (float)i, y + (float)j, 0.0f);
+            const char* bytes = (const char*)&vertex;
+            vertexData.insert(vertexData.end(), bytes, bytes + sizeof(Vertex));
+        }
+    }
+}
+
+static GLsizei FormatStride(int format)
+{
+    return format == 0 ? PositionLayout::stride : format == 1 ? LitLayout::stride : TexturedLayout::stride;
+}
+
+static GLuint FormatPositionOffset(int format)
+{
+    return format == 0 ? offsetof(PositionVertex, position) : format == 1 ? offsetof(LitVertex, position) : offsetof(TexturedVertex, position);
+}
+
+static void BindFormat(int format, GLuint vertexBuffer, GLintptr offset, GLuint elementBuffer)
+{
+    if (format == 0) BindVertexLayout<PositionLayout>(vertexBuffer, offset, elementBuffer);
+    else if (format == 1) BindVertexLayout<LitLayout>(vertexBuffer, offset, elementBuffer);
+    else BindVertexLayout<TexturedLayout>(vertexBuffer, offset, elementBuffer);
+}
+
+static double Seconds(Uint64 start, Uint64 end)
+{
+    return (double)(end - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+#ifdef _WIN32
+int wmain(int argc, char** argv)
+#else
+int main(int argc, char** argv)
+#endif
+{
+    int meshCount = argc > 1 ? atoi(argv[1]) : 3000;
+    int passes = argc > 2 ? atoi(argv[2]) : 100;
+
+    SDL_Init(SDL_INIT_VIDEO);
+    err_checkSDL("Unable to init SDL video");
+    atexit(SDL_Quit);
+
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, 1);
+
+    std::unique_ptr<SDL_Window, void(*)(SDL_Window *)> window(
+        SDL_CreateWindow("Vertex Pulling Benchmark", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 64, 64, SDL_WINDOW_HIDDEN | SDL_WINDOW_OPENGL),
+        SDL_DestroyWindow);
+    err_checkSDL("Unable to open SDL window");
+
+    std::unique_ptr<void, void(*)(void *)> context(
+        SDL_GL_CreateContext(window.get()),
+        SDL_GL_DeleteContext);
+    err_checkSDL("Unable to create OpenGL context");
+
+    glewExperimental = true; // Needed in core profile
+    GLenum glerr = glewInit();
+    if (glerr != GLEW_OK)
+        err_fatalf("Failed to initialize GLEW: %s", glewGetErrorString(glerr));
+    else if (!GLEW_VERSION_4_5)
+        err_fatalf("Failed to initialize GLEW: OpenGL 4.5 extensions not supported/loaded");
+    if (!IsVertexPullingSupported())
+        err_fatalf("Vertex pulling needs OpenGL 4.6 or GL_ARB_shader_draw_parameters");
+    err_clearGL();
+
+    // Each format gets its own region of the vertex buffer, so a multi-draw per format can reach all its
+    // meshes through baseVertex; the meshes themselves alternate formats
+    std::vector<char> regions[FORMAT_COUNT];
+    std::vector<Mesh> meshes(meshCount);
+    std::vector<GLuint> indices;
+    for (int m = 0; m < meshCount; ++m)
+    {
+        Mesh& mesh = meshes[m];
+        mesh.format = m % FORMAT_COUNT;
+        mesh.firstVertex = (GLuint)(regions[mesh.format].size() / FormatStride(mesh.format));
+        mesh.firstIndex = (GLuint)indices.size();
+        float x = (float)(m % 10) * GRID - 40.0f, y = (float)(m / 10 % 10) * GRID - 40.0f;
+        if (mesh.format == 0) AppendVertices<PositionVertex>(regions[0], x, y);
+        else if (mesh.format == 1) AppendVertices<LitVertex>(regions[1], x, y);
+        else AppendVertices<TexturedVertex>(regions[2], x, y);
+
+        // Indices are local to the mesh; where its vertices are comes from the draw
+        for (int j = 0; j + 1 < GRID; ++j)
+        {
+            for (int i = 0; i + 1 < GRID; ++i)
+            {
+                GLuint corner = (GLuint)(j * GRID + i);
+                GLuint quad[6] = { corner, corner + 1, corner + GRID, corner + 1, corner + GRID + 1, corner + GRID };
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+    }
+    GLuint indicesPerMesh = (GLuint)(indices.size() / meshCount);
+
+    std::vector<char> vertexData;
+    GLintptr regionStart[FORMAT_COUNT];
+    for (int f = 0; f < FORMAT_COUNT; ++f)
+    {
+        regionStart[f] = (GLintptr)vertexData.size();
+        vertexData.insert(vertexData.end(), regions[f].begin(), regions[f].end());
+    }
+    for (Mesh& mesh : meshes)
+        mesh.firstByte = regionStart[mesh.format] + (GLintptr)mesh.firstVertex * FormatStride(mesh.format);
+
+    Buffer vertexBuffer = CreateBuffer();
+    glNamedBufferStorage(vertexBuffer.get(), vertexData.size(), vertexData.data(), 0);
+    Buffer elementBuffer = CreateBuffer();
+    glNamedBufferStorage(elementBuffer.get(), indices.size() * sizeof(GLuint), indices.data(), 0);
+
+    // Commands sorted by format for the vertex array path, and in mesh order for the pulled path
+    std::vector<DrawElementsIndirectCommand> formatCommands, pulledCommands;
+    std::vector<VertexPullingDraw> pulledDraws;
+    GLintptr formatCommandStart[FORMAT_COUNT + 1];
+    for (int f = 0; f < FORMAT_COUNT; ++f)
+    {
+        formatCommandStart[f] = (GLintptr)formatCommands.size();
+        for (const Mesh& mesh : meshes)
+            if (mesh.format == f)
+                formatCommands.push_back({ indicesPerMesh, 1, mesh.firstIndex, (GLint)mesh.firstVertex, 0 });
+    }
+    formatCommandStart[FORMAT_COUNT] = (GLintptr)formatCommands.size();
+    for (const Mesh& mesh : meshes)
+    {
+        pulledCommands.push_back({ indicesPerMesh, 1, mesh.firstIndex, 0, 0 });
+        pulledDraws.push_back(MakeVertexPullingDraw(mesh.firstByte, FormatStride(mesh.format), FormatPositionOffset(mesh.format)));
+    }
+
+    Buffer formatCommandBuffer = CreateBuffer();
+    glNamedBufferStorage(formatCommandBuffer.get(), formatCommands.size() * sizeof(DrawElementsIndirectCommand), formatCommands.data(), 0);
+    Buffer pulledCommandBuffer = CreateBuffer();
+    glNamedBufferStorage(pulledCommandBuffer.get(), pulledCommands.size() * sizeof(DrawElementsIndirectCommand), pulledCommands.data(), 0);
+    Buffer pulledDrawBuffer = CreateBuffer();
+    glNamedBufferStorage(pulledDrawBuffer.get(), pulledDraws.size() * sizeof(VertexPullingDraw), pulledDraws.data(), 0);
+    err_checkGL("Loading meshes");
+
+    Program attributeProgram = LoadShaderProgramSource(fragmentSource, attributeVertexSource);
+    Program pulledProgram = LoadShaderProgramSource(fragmentSource, pulledVertexSource);
+
+    // Vertex arrays, one draw per mesh
+    glUseProgram(attributeProgram.get());
+    glFinish();
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (const Mesh& mesh : meshes)
+        {
+            BindFormat(mesh.format, vertexBuffer.get(), mesh.firstByte, elementBuffer.get());
+            glDrawElements(GL_TRIANGLES, indicesPerMesh, GL_UNSIGNED_INT, (const void*)(mesh.firstIndex * sizeof(GLuint)));
+        }
+    }
+    glFinish();
+    double perMesh = Seconds(start, SDL_GetPerformanceCounter());
+    err_checkGL("Vertex arrays, draw per mesh");
+
+    // Vertex arrays, one multi-draw per format
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, formatCommandBuffer.get());
+    start = SDL_GetPerformanceCounter();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (int f = 0; f < FORMAT_COUNT; ++f)
+        {
+            BindFormat(f, vertexBuffer.get(), regionStart[f], elementBuffer.get());
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                (const void*)(formatCommandStart[f] * sizeof(DrawElementsIndirectCommand)),
+                (GLsizei)(formatCommandStart[f + 1] - formatCommandStart[f]), sizeof(DrawElementsIndirectCommand));
+        }
+    }
+    glFinish();
+    double perFormat = Seconds(start, SDL_GetPerformanceCounter());
+    err_checkGL("Vertex arrays, multi-draw per format");
+
+    // Vertex pulling, one multi-draw for everything
+    glUseProgram(pulledProgram.get());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, pulledCommandBuffer.get());
+    start = SDL_GetPerformanceCounter();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        BindVertexPulling(vertexBuffer.get(), pulledDrawBuffer.get(), elementBuffer.get());
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, meshCount, sizeof(DrawElementsIndirectCommand));
+    }
+    glFinish();
+    double pulled = Seconds(start, SDL_GetPerformanceCounter());
+    err_checkGL("Vertex pulling");
+
+    printf("%d meshes in %d formats, %u triangles each, %d passes\n", meshCount, FORMAT_COUNT, indicesPerMesh / 3, passes);
+    printf("%-26s %14s %14s\n", "", "draws/pass", "ms/pass");
+    printf("%-26s %14d %14.3f\n", "vertex arrays, per mesh", meshCount, perMesh * 1000.0 / passes);
+    printf("%-26s %14d %14.3f\n", "vertex arrays, per format", FORMAT_COUNT, perFormat * 1000.0 / passes);
+    printf("%-26s %14d %14.3f\n", "vertex pulling", 1, pulled * 1000.0 / passes);
+
+    // Clean up while the context is still current
+    glUseProgram(0);
+    ClearVertexArrayCache();
+    return 0;
+}